@@ -39,14 +39,72 @@
 #include "sqlite3ext.h"
 #endif
 SQLITE_EXTENSION_INIT1
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
+#include <float.h>
+#include <stdarg.h>
+
+/*
+** The diropt engine can spread each level of a traversal over several
+** threads (see the threads option).  Compile with -DBFSVTAB_OMIT_THREADS
+** to leave that out, so that every traversal runs on the calling thread.
+*/
+#if !defined(BFSVTAB_OMIT_THREADS) && !defined(_WIN32)
+# include <pthread.h>
+# define BFSVTAB_THREADS 1
+#else
+# define BFSVTAB_THREADS 0
+#endif
+
+/*
+** adjacency = 'mapped' writes the in-memory adjacency to a file next to
+** the database and maps it with mmap().  Compile with -DBFSVTAB_OMIT_MMAP
+** to leave that out, so that 'mapped' works just like 'csr'.
+*/
+#if !defined(BFSVTAB_OMIT_MMAP) && !defined(_WIN32)
+# include <stdio.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# define BFSVTAB_MMAP 1
+#else
+# define BFSVTAB_MMAP 0
+#endif
+
+#ifndef LARGEST_INT64
+# define LARGEST_INT64 (0xffffffff|(((sqlite3_int64)0x7fffffff)<<32))
+#endif
 
 typedef struct bfsvtab_avl bfsvtab_avl;
+typedef struct bfsvtab_batch bfsvtab_batch;
+typedef struct bfsvtab_cache bfsvtab_cache;
+typedef struct bfsvtab_csr bfsvtab_csr;
+typedef struct bfsvtab_delta bfsvtab_delta;
+typedef struct bfsvtab_diropt bfsvtab_diropt;
+typedef struct bfsvtab_dijkstra bfsvtab_dijkstra;
+typedef struct bfsvtab_hash bfsvtab_hash;
+typedef struct bfsvtab_hash_entry bfsvtab_hash_entry;
+typedef struct bfsvtab_keys bfsvtab_keys;
+typedef struct bfsvtab_map_header bfsvtab_map_header;
+typedef struct bfsvtab_msbfs bfsvtab_msbfs;
 typedef struct bfsvtab_node bfsvtab_node;
+typedef struct bfsvtab_paths bfsvtab_paths;
 typedef struct bfsvtab_queue bfsvtab_queue;
+typedef struct bfsvtab_shared bfsvtab_shared;
+typedef struct bfsvtab_shared_entry bfsvtab_shared_entry;
+typedef struct bfsvtab_slab bfsvtab_slab;
+typedef struct bfsvtab_stmt bfsvtab_stmt;
 
+
+/*
+** The set of visited nodes is kept in an open-addressing hash table by
+** default.  Compile with -DBFSVTAB_USE_AVL to use the original AVL tree
+** instead, for example to benchmark one against the other.
+*/
+#ifdef BFSVTAB_USE_AVL
 /*****************************************************************************
 ** AVL Tree implementation
 */
@@ -243,522 +301,6608 @@ static bfsvtab_avl *bfsvtabAvlInsert(
     return 0;
 }
 
-/* Walk the tree can call xDestroy on each node
-*/
-static void bfsvtabAvlDestroy(bfsvtab_avl *p, void (*xDestroy)(bfsvtab_avl*)) {
-    if (p) {
-        bfsvtabAvlDestroy(p->pBefore, xDestroy);
-        bfsvtabAvlDestroy(p->pAfter, xDestroy);
-        xDestroy(p);
-    }
-}
 /*
 ** End of the AVL Tree implementation
 ******************************************************************************/
-
-struct bfsvtab_node {
-    sqlite3_int64 id;
-    sqlite3_int64 parent;
-    sqlite3_int64 distance;
-
-    struct bfsvtab_node *pList;
+/*****************************************************************************
+** Slab allocator for the entries of the AVL tree
+**
+** Hands out items of a single fixed size, carved from chunks of
+** BFSVTAB_SLAB_CHUNK bytes.  bfsvtabSlabClear() releases every item at
+** once, one chunk at a time, without visiting the items.
+*/
+struct bfsvtab_slab {
+    int szItem;                 /* Size of an item, in bytes */
+    int nLeft;                  /* Unused items left in the newest chunk */
+    char *pNext;                /* Next unused item in the newest chunk */
+    void *pChunk;               /* Newest chunk, or NULL */
+    sqlite3_int64 nItem;        /* Number of items handed out */
 };
 
-/* A queue of nodes */
-struct bfsvtab_queue {
-  bfsvtab_node *pFirst;       /* Oldest node on the queue */
-  bfsvtab_node *pLast;        /* Youngest node on the queue */
-};
+#define BFSVTAB_SLAB_CHUNK 65536
 
 /*
-** Add a node to the end of the queue
+** Prepare p to hand out items of szItem bytes.
 */
-static void queuePush(bfsvtab_queue *pQueue, bfsvtab_node *pNode){
-  pNode->pList = 0;
-  if( pQueue->pLast ){
-    pQueue->pLast->pList = pNode;
-  }else{
-    pQueue->pFirst = pNode;
-  }
-  pQueue->pLast = pNode;
+static void bfsvtabSlabInit(bfsvtab_slab *p, int szItem) {
+    memset(p, 0, sizeof(*p));
+    p->szItem = (szItem + 7) & ~7;
 }
 
 /*
-** Extract the oldest element (the front element) from the queue.
+** Return a new item from p, or NULL if out of memory.  The contents of
+** the item are undefined.
 */
-static bfsvtab_node *queuePull(bfsvtab_queue *pQueue){
-  bfsvtab_node *p = pQueue->pFirst;
-  if( p ){
-    pQueue->pFirst = p->pList;
-    if( pQueue->pFirst==0 ) pQueue->pLast = 0;
-  }
-  return p;
+static void *bfsvtabSlabAlloc(bfsvtab_slab *p) {
+    void *pItem;
+    if (p->nLeft == 0) {
+        /* Each chunk starts with a link to the chunk before it */
+        char *pChunk = sqlite3_malloc(BFSVTAB_SLAB_CHUNK);
+        if (pChunk == 0) {
+            return 0;
+        }
+        *(void**)pChunk = p->pChunk;
+        p->pChunk = pChunk;
+        p->pNext = pChunk + 8;
+        p->nLeft = (BFSVTAB_SLAB_CHUNK - 8) / p->szItem;
+    }
+    pItem = p->pNext;
+    p->pNext += p->szItem;
+    p->nLeft--;
+    p->nItem++;
+    return pItem;
 }
 
-static void queueDestroy(bfsvtab_queue *pQueue, void (*xDestroy)(bfsvtab_node*)) {
-    bfsvtab_node *p = pQueue->pFirst, *next;
-    while (p) {
-        next = p->pList;
-        xDestroy(p);
-        p = next;
+/*
+** Release every item of p.  p can be used again afterwards.
+*/
+static void bfsvtabSlabClear(bfsvtab_slab *p) {
+    while (p->pChunk) {
+        void *pPrev = *(void**)p->pChunk;
+        sqlite3_free(p->pChunk);
+        p->pChunk = pPrev;
     }
+    p->nLeft = 0;
+    p->pNext = 0;
+    p->nItem = 0;
 }
+/*
+** End of the slab allocator
+******************************************************************************/
 
+#endif /* defined(BFSVTAB_USE_AVL) */
+
+/*****************************************************************************
+** Hash table implementation
+*/
 /*
-** This function converts an SQL quoted string into an unquoted string
-** and returns a pointer to a buffer allocated using sqlite3_malloc() 
-** containing the result. The caller should eventually free this buffer
-** using sqlite3_free.
-**
-** Examples:
+** A map from node id to a second integer (the parent id, for the set of
+** visited nodes).  All entries are stored in a single array of nSlot
+** slots, where nSlot is a power of two, and collisions are resolved by
+** linear probing.  The array is doubled whenever it becomes half full.
 **
-**     "abc"   becomes   abc
-**     'xyz'   becomes   xyz
-**     [pqr]   becomes   pqr
-**     `mno`   becomes   mno
+** A slot whose id is BFSVTAB_HASH_EMPTY is unused.  Since that value is
+** also a legal node id, an entry with that id is stored in sEmpty
+** instead of in the array.
 */
-static char *bfsvtabDequote(const char *zIn) {
-    sqlite3_int64 nIn;              /* Size of input string, in bytes */
-    char *zOut;                     /* Output (dequoted) string */
+#define BFSVTAB_HASH_EMPTY ((sqlite3_int64)(((sqlite3_uint64)1)<<63))
+#define BFSVTAB_HASH_MINSLOT 64
 
-    nIn = strlen(zIn);
-    zOut = sqlite3_malloc64(nIn + 1);
-    if (zOut) {
-        char q = zIn[0];              /* Quote character (if any ) */
+struct bfsvtab_hash_entry {
+    sqlite3_int64 id;           /* Key.  BFSVTAB_HASH_EMPTY if unused */
+    sqlite3_int64 value;        /* Value associated with id */
+};
 
-        if (q != '[' && q != '\'' && q != '"' && q != '`') {
-            memcpy(zOut, zIn, (size_t)(nIn + 1));
-        } else {
-            int iOut = 0;               /* Index of next byte to write to output */
-            int iIn;                    /* Index of next byte to read from input */
+struct bfsvtab_hash {
+    bfsvtab_hash_entry *aSlot;  /* Array of nSlot slots */
+    sqlite3_int64 nSlot;        /* Size of aSlot[].  Zero or a power of 2 */
+    sqlite3_int64 nEntry;       /* Number of used slots in aSlot[] */
+    int bEmpty;                 /* True if sEmpty holds an entry */
+    bfsvtab_hash_entry sEmpty;  /* Entry for id BFSVTAB_HASH_EMPTY */
+};
 
-            if (q == '[') {
-                q = ']';
-            }
-            for (iIn = 1; iIn < nIn; iIn++) {
-                if (zIn[iIn] == q) {
-                    iIn++;
-                }
-                zOut[iOut++] = zIn[iIn];
-            }
+/* Return the slot at which a search for id should begin.
+*/
+static sqlite3_int64 bfsvtabHashStart(bfsvtab_hash *pHash, sqlite3_int64 id) {
+    sqlite3_uint64 h = (sqlite3_uint64)id;
+    h ^= h >> 33;
+    h *= (((sqlite3_uint64)0xff51afd7)<<32) | 0xed558ccd;
+    h ^= h >> 33;
+    return (sqlite3_int64)(h & (sqlite3_uint64)(pHash->nSlot - 1));
+}
+
+/* Search the table for an entry with id.  Return a pointer to the
+** entry or return NULL.
+*/
+static bfsvtab_hash_entry *bfsvtabHashSearch(
+    bfsvtab_hash *pHash,
+    sqlite3_int64 id
+) {
+    sqlite3_int64 i;
+    if (id == BFSVTAB_HASH_EMPTY) {
+        return pHash->bEmpty ? &pHash->sEmpty : 0;
+    }
+    if (pHash->nSlot == 0) {
+        return 0;
+    }
+    i = bfsvtabHashStart(pHash, id);
+    while (pHash->aSlot[i].id != BFSVTAB_HASH_EMPTY) {
+        if (pHash->aSlot[i].id == id) {
+            return &pHash->aSlot[i];
         }
-        assert((int)strlen(zOut) <= nIn);
+        i = (i + 1) & (pHash->nSlot - 1);
     }
-    return zOut;
+    return 0;
 }
 
-/*
-** Check to see if the argument is of the form:
-**
-**       KEY = VALUE
-**
-** If it is, return a pointer to the first character of VALUE.
-** If not, return NULL.  Spaces around the = are ignored.
+/* Resize the slot array to nSlot entries and rehash every entry into it.
 */
-static const char *bfsvtabValueOfKey(const char *zKey, const char *zStr){
-    int nKey = (int)strlen(zKey);
-    int nStr = (int)strlen(zStr);
-    int i;
-    if (nStr < nKey + 1) {
-        return 0;
+static int bfsvtabHashResize(bfsvtab_hash *pHash, sqlite3_int64 nSlot) {
+    bfsvtab_hash_entry *aOld = pHash->aSlot;
+    sqlite3_int64 nOld = pHash->nSlot;
+    sqlite3_int64 i, j;
+
+    pHash->aSlot = sqlite3_malloc64(nSlot * sizeof(bfsvtab_hash_entry));
+    if (pHash->aSlot == 0) {
+        pHash->aSlot = aOld;
+        return SQLITE_NOMEM;
     }
-    if (memcmp(zStr, zKey, nKey) != 0) {
-        return 0;
+    pHash->nSlot = nSlot;
+    for (i = 0; i < nSlot; i++) {
+        pHash->aSlot[i].id = BFSVTAB_HASH_EMPTY;
     }
-    for (i = nKey; isspace((unsigned char)zStr[i]); i++) {
-        ;
+    for (i = 0; i < nOld; i++) {
+        if (aOld[i].id == BFSVTAB_HASH_EMPTY) {
+            continue;
+        }
+        j = bfsvtabHashStart(pHash, aOld[i].id);
+        while (pHash->aSlot[j].id != BFSVTAB_HASH_EMPTY) {
+            j = (j + 1) & (nSlot - 1);
+        }
+        pHash->aSlot[j] = aOld[i];
     }
-    if (zStr[i] != '=') {
-        return 0;
+    sqlite3_free(aOld);
+    return SQLITE_OK;
+}
+
+/* Insert a new entry mapping id to value.  If an entry with the same id
+** already exists, leave it unchanged and set *pbNew to 0.  Otherwise set
+** *pbNew to 1.  Return SQLITE_OK on success or SQLITE_NOMEM if the slot
+** array could not be grown.
+*/
+static int bfsvtabHashInsert(
+    bfsvtab_hash *pHash,
+    sqlite3_int64 id,
+    sqlite3_int64 value,
+    int *pbNew
+) {
+    sqlite3_int64 i;
+    *pbNew = 0;
+    if (id == BFSVTAB_HASH_EMPTY) {
+        if (pHash->bEmpty == 0) {
+            pHash->bEmpty = 1;
+            pHash->sEmpty.id = id;
+            pHash->sEmpty.value = value;
+            *pbNew = 1;
+        }
+        return SQLITE_OK;
     }
-    i++;
-    while (isspace((unsigned char)zStr[i])) { 
-        i++; 
+    if ((pHash->nEntry + 1) * 2 > pHash->nSlot) {
+        int rc = bfsvtabHashResize(pHash,
+            pHash->nSlot ? pHash->nSlot * 2 : BFSVTAB_HASH_MINSLOT);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
     }
-    return zStr + i;
+    i = bfsvtabHashStart(pHash, id);
+    while (pHash->aSlot[i].id != BFSVTAB_HASH_EMPTY) {
+        if (pHash->aSlot[i].id == id) {
+            return SQLITE_OK;
+        }
+        i = (i + 1) & (pHash->nSlot - 1);
+    }
+    pHash->aSlot[i].id = id;
+    pHash->aSlot[i].value = value;
+    pHash->nEntry++;
+    *pbNew = 1;
+    return SQLITE_OK;
 }
 
-/* bfsvtab_vtab is a subclass of sqlite3_vtab which is
-** underlying representation of the virtual table
+/* Free the slot array and reset the table to empty.
 */
-typedef struct bfsvtab_vtab bfsvtab_vtab;
-struct bfsvtab_vtab {
-    sqlite3_vtab base;  /* Base class - must be first */
-    /* Add new fields here, as necessary */
-    char *zDb;
-    char *zSelf;
-    char *zTableName;
-    char *zFromColumn;
-    char *zToColumn;
-    sqlite3 *db;
+static void bfsvtabHashClear(bfsvtab_hash *pHash) {
+    sqlite3_free(pHash->aSlot);
+    memset(pHash, 0, sizeof(*pHash));
+}
+/* Remove every entry from the table but keep the slot array for reuse.
+*/
+static void bfsvtabHashReset(bfsvtab_hash *pHash) {
+    sqlite3_int64 i;
+    for (i = 0; i < pHash->nSlot; i++) {
+        pHash->aSlot[i].id = BFSVTAB_HASH_EMPTY;
+    }
+    pHash->nEntry = 0;
+    pHash->bEmpty = 0;
+}
+
+/*
+** End of the hash table implementation
+******************************************************************************/
+
+/*
+** A growable array of node keys.
+*/
+struct bfsvtab_keys {
+    sqlite3_int64 n;            /* Number of keys in a[] */
+    sqlite3_int64 nAlloc;       /* Allocated size of a[] */
+    sqlite3_int64 *a;           /* The keys */
 };
 
-/* bfsvtab_cursor is a subclass of sqlite3_vtab_cursor which will
-** serve as the underlying representation of a cursor that scans
-** over rows of the result
+/*
+** Append iKey to the end of the array.
 */
-typedef struct bfsvtab_cursor bfsvtab_cursor;
-struct bfsvtab_cursor {
-    sqlite3_vtab_cursor base;  /* Base class - must be first */
-    /* Insert new fields here.  For this bfsvtab we only keep track
-    ** of the rowid */
-    sqlite3_int64 iRowid;      /* The rowid */
-    sqlite3_stmt *pStmt;       /* Prepared statement to return node neighbours */
+static int bfsvtabKeysAppend(bfsvtab_keys *p, sqlite3_int64 iKey) {
+    if (p->n >= p->nAlloc) {
+        sqlite3_int64 nNew = p->nAlloc ? p->nAlloc * 2 : 64;
+        sqlite3_int64 *aNew = sqlite3_realloc64(p->a, nNew * sizeof(sqlite3_int64));
+        if (aNew == 0) {
+            return SQLITE_NOMEM;
+        }
+        p->a = aNew;
+        p->nAlloc = nNew;
+    }
+    p->a[p->n++] = iKey;
+    return SQLITE_OK;
+}
 
-    bfsvtab_vtab *pVtab;       /* The virtual table this cursor belongs to */
-    char *zTableName;          /* Name of table holding edge relation */
-    char *zFromColumn;         /* Name of from column of zTableName */
-    char *zToColumn;           /* Name of to column of zTableName */
+/*
+** Free the array and reset it to empty.
+*/
+static void bfsvtabKeysClear(bfsvtab_keys *p) {
+    sqlite3_free(p->a);
+    memset(p, 0, sizeof(*p));
+}
 
-    bfsvtab_avl *pVisited;     /* Set of Visited Nodes */
+/*
+** The shortest_path strings of nodes at one distance from the root.  Each
+** string in z[] is preceded by its length, and index maps a node key to
+** the offset of that length.  A cursor keeps two of these, for the level
+** of the current row and the level above it, so that the path of a row is
+** its parent's path with one id appended.
+*/
+struct bfsvtab_paths {
+    sqlite3_int64 iDistance;    /* Distance of the nodes, or -1 if unused */
+    bfsvtab_hash index;         /* Map from node key to offset in z[] */
+    char *z;                    /* Lengths and path strings */
+    sqlite3_int64 n;            /* Bytes used in z[] */
+    sqlite3_int64 nAlloc;       /* Bytes allocated for z[] */
+};
 
-    bfsvtab_queue pQueue;      /* Queue of next Nodes */
-    bfsvtab_node *pCurrent;     /* Current element of output */
-    sqlite3_int64 root;
+/*
+** Remove every path but keep the allocations for reuse by the nodes at
+** distance iDistance.
+*/
+static void bfsvtabPathsReset(bfsvtab_paths *p, sqlite3_int64 iDistance) {
+    bfsvtabHashReset(&p->index);
+    p->n = 0;
+    p->iDistance = iDistance;
+}
 
-};
+/*
+** Free the paths and reset p to unused.
+*/
+static void bfsvtabPathsClear(bfsvtab_paths *p) {
+    bfsvtabHashClear(&p->index);
+    sqlite3_free(p->z);
+    memset(p, 0, sizeof(*p));
+    p->iDistance = -1;
+}
 
 /*
-** Deallocate a bfsvtab_vtab object
+** If the path of node iKey is stored in p, set *pz and *pn to it and
+** return 1.  Otherwise return 0.
 */
-static void bfsvtabFree(bfsvtab_vtab *p) {
-    if (p) {
-        sqlite3_free(p->zDb);
-        sqlite3_free(p->zSelf);
-        sqlite3_free(p->zTableName);
-        sqlite3_free(p->zFromColumn);
-        sqlite3_free(p->zToColumn);
-        memset(p, 0, sizeof(*p));
-        sqlite3_free(p);
+static int bfsvtabPathsFind(
+    bfsvtab_paths *p,
+    sqlite3_int64 iKey,
+    const char **pz,
+    sqlite3_int64 *pn
+) {
+    bfsvtab_hash_entry *pEntry = bfsvtabHashSearch(&p->index, iKey);
+    if (pEntry == 0) {
+        return 0;
     }
+    memcpy(pn, &p->z[pEntry->value], sizeof(sqlite3_int64));
+    *pz = &p->z[pEntry->value + sizeof(sqlite3_int64)];
+    return 1;
 }
 
 /*
-** The bfsvtabConnect() method is invoked to create a new
-** bfs virtual table.
-**
-** Think of this routine as the constructor for bfsvtab_vtab objects.
-**
-** All this routine needs to do is:
-**
-**    (1) Allocate the bfsvtab_vtab object and initialize all fields.
-**
-**    (2) Tell SQLite (via the sqlite3_declare_vtab() interface) what the
-**        result set of queries against the virtual table will look like.
+** Store the concatenation of the nPrefix bytes at zPrefix and the string
+** zTail as the path of node iKey, and point *pz and *pn at it.  zPrefix
+** must not point into p itself.
 */
-static int bfsvtabConnect(
-    sqlite3 *db,
-    void *pAux,
-    int argc, const char *const*argv,
-    sqlite3_vtab **ppVtab,
-    char **pzErr
+static int bfsvtabPathsAdd(
+    bfsvtab_paths *p,
+    sqlite3_int64 iKey,
+    const char *zPrefix,
+    sqlite3_int64 nPrefix,
+    const char *zTail,
+    const char **pz,
+    sqlite3_int64 *pn
 ) {
-    bfsvtab_vtab *pNew;
-    int i;
+    sqlite3_int64 nTail = (sqlite3_int64)strlen(zTail);
+    sqlite3_int64 nPath = nPrefix + nTail;
+    sqlite3_int64 iOff = p->n;
+    int bNew;
     int rc;
-    const char *zVal;
 
-    (void) pAux;
-    *ppVtab = 0;
-    rc = SQLITE_OK;
-
-    pNew = sqlite3_malloc(sizeof(*pNew));
-    if (pNew == 0) {
-        return SQLITE_NOMEM;
+    if (p->n + (sqlite3_int64)sizeof(sqlite3_int64) + nPath > p->nAlloc) {
+        sqlite3_int64 nNew = p->nAlloc ? p->nAlloc * 2 : 4096;
+        char *zNew;
+        while (nNew < p->n + (sqlite3_int64)sizeof(sqlite3_int64) + nPath) {
+            nNew *= 2;
+        }
+        zNew = sqlite3_realloc64(p->z, nNew);
+        if (zNew == 0) {
+            return SQLITE_NOMEM;
+        }
+        p->z = zNew;
+        p->nAlloc = nNew;
     }
-    memset(pNew, 0, sizeof(*pNew));
-
-    pNew->db = db;
-    pNew->zDb = sqlite3_mprintf("%s", argv[1]);
-    if (pNew->zDb == 0) {
-        rc = SQLITE_NOMEM;
-        goto connectError;
+    rc = bfsvtabHashInsert(&p->index, iKey, iOff, &bNew);
+    if (rc != SQLITE_OK) {
+        return rc;
     }
-
-    pNew->zSelf = sqlite3_mprintf("%s", argv[2]);
-    if (pNew->zSelf == 0) {
-        rc = SQLITE_NOMEM;
-        goto connectError;
+    memcpy(&p->z[iOff], &nPath, sizeof(sqlite3_int64));
+    if (nPrefix > 0) {
+        memcpy(&p->z[iOff + sizeof(sqlite3_int64)], zPrefix, nPrefix);
     }
+    memcpy(&p->z[iOff + sizeof(sqlite3_int64) + nPrefix], zTail, nTail);
+    p->n = iOff + sizeof(sqlite3_int64) + nPath;
+    *pz = &p->z[iOff + sizeof(sqlite3_int64)];
+    *pn = nPath;
+    return SQLITE_OK;
+}
 
-    for (i = 3; i < argc; i++) {
-        zVal = bfsvtabValueOfKey("tablename", argv[i]);
-        if (zVal) {
-            sqlite3_free(pNew->zTableName);
-            pNew->zTableName = bfsvtabDequote(zVal);
-            if (pNew->zTableName == 0) {
-                rc = SQLITE_NOMEM;
-                goto connectError;
-            }
-            continue;
-        }
-        zVal = bfsvtabValueOfKey("fromcolumn", argv[i]);
-        if (zVal) {
-            sqlite3_free(pNew->zFromColumn);
-            pNew->zFromColumn = bfsvtabDequote(zVal);
-            if (pNew->zFromColumn == 0) {
-                rc = SQLITE_NOMEM;
-                goto connectError;
-            }
-            continue;
+/*
+** The node of the current row.  The id and parent fields hold node keys:
+** the node id itself, or the node's index in the in-memory adjacency when
+** one is in use (see bfsvtabNodeId()).
+*/
+struct bfsvtab_node {
+    sqlite3_int64 id;
+    sqlite3_int64 parent;
+    sqlite3_int64 distance;     /* Number of edges from the root */
+    double rCost;               /* Path weight, with a weight column */
+};
+
+/*
+** A queue of node keys, held in a ring buffer that doubles in size when
+** full.  A breadth-first queue only ever holds nodes from two adjacent
+** levels, so the distance of each key is implied by its position: the
+** first nLevel keys are at iDistance, and the rest are one further on.
+*/
+struct bfsvtab_queue {
+    sqlite3_int64 *aKey;        /* Ring buffer of node keys */
+    sqlite3_int64 nAlloc;       /* Size of aKey[], zero or a power of two */
+    sqlite3_int64 iHead;        /* Index in aKey[] of the oldest key */
+    sqlite3_int64 nKey;         /* Number of keys on the queue */
+    sqlite3_int64 nLevel;       /* Number of keys at distance iDistance */
+    sqlite3_int64 iDistance;    /* Distance of the most recently pulled key */
+};
+
+/*
+** Add a node key to the end of the queue.  The node must be one level
+** further from the root than the most recently pulled one.
+*/
+static int queuePush(bfsvtab_queue *pQueue, sqlite3_int64 iKey){
+  if( pQueue->nKey==pQueue->nAlloc ){
+    sqlite3_int64 nNew = pQueue->nAlloc ? pQueue->nAlloc*2 : 256;
+    sqlite3_int64 *aNew = sqlite3_realloc64(pQueue->aKey, nNew*sizeof(sqlite3_int64));
+    if( aNew==0 ) return SQLITE_NOMEM;
+    /* Move the keys that had wrapped around to just past the old end */
+    memcpy(&aNew[pQueue->nAlloc], aNew, pQueue->iHead*sizeof(sqlite3_int64));
+    pQueue->aKey = aNew;
+    pQueue->nAlloc = nNew;
+  }
+  pQueue->aKey[(pQueue->iHead + pQueue->nKey) & (pQueue->nAlloc-1)] = iKey;
+  pQueue->nKey++;
+  return SQLITE_OK;
+}
+
+/*
+** Extract the oldest key (the front element) from the queue into *piKey,
+** and its distance from the root into *piDistance.  Return 0 if the queue
+** is empty.
+*/
+static int queuePull(
+  bfsvtab_queue *pQueue,
+  sqlite3_int64 *piKey,
+  sqlite3_int64 *piDistance
+){
+  if( pQueue->nKey==0 ) return 0;
+  if( pQueue->nLevel==0 ){
+    /* Every key left is on the next level */
+    pQueue->iDistance++;
+    pQueue->nLevel = pQueue->nKey;
+  }
+  *piKey = pQueue->aKey[pQueue->iHead];
+  *piDistance = pQueue->iDistance;
+  pQueue->iHead = (pQueue->iHead + 1) & (pQueue->nAlloc-1);
+  pQueue->nKey--;
+  pQueue->nLevel--;
+  return 1;
+}
+
+/*
+** Return the key of the i-th oldest node on the queue.
+*/
+static sqlite3_int64 queuePeek(bfsvtab_queue *pQueue, sqlite3_int64 i){
+  assert( i<pQueue->nKey );
+  return pQueue->aKey[(pQueue->iHead + i) & (pQueue->nAlloc-1)];
+}
+
+/*
+** Empty the queue, ready for a traversal that starts by pushing the root.
+*/
+static void queueReset(bfsvtab_queue *pQueue){
+  pQueue->iHead = 0;
+  pQueue->nKey = 0;
+  pQueue->nLevel = 0;
+  pQueue->iDistance = -1;
+}
+
+/*
+** Empty the queue and free its buffer.
+*/
+static void queueClear(bfsvtab_queue *pQueue){
+  sqlite3_free(pQueue->aKey);
+  memset(pQueue, 0, sizeof(*pQueue));
+  queueReset(pQueue);
+}
+
+/*
+** State used to expand several queued nodes with a single statement
+** when the batch size is greater than one.
+*/
+struct bfsvtab_batch {
+    int nMax;                  /* Maximum number of nodes per statement */
+    int nNode;                 /* Number of nodes in aNode[] */
+    sqlite3_int64 *aNode;      /* Keys of the nodes expanded by the statement */
+    bfsvtab_hash pos;          /* Map from node id to index in aNode[] */
+    sqlite3_int64 nEdge;       /* Number of edges in aEdge[] */
+    sqlite3_int64 nEdgeAlloc;  /* Allocated size of aEdge[], in edges */
+    sqlite3_int64 *aEdge;      /* Edges as (index in aNode[], to) pairs */
+    sqlite3_int64 *aSorted;    /* The "to" half of aEdge[], grouped by node */
+    sqlite3_int64 *aEnd;       /* End of each node's group in aSorted[] */
+};
+
+/*
+** Free all memory held by a bfsvtab_batch and zero it.
+*/
+static void bfsvtabBatchClear(bfsvtab_batch *p) {
+    sqlite3_free(p->aNode);
+    bfsvtabHashClear(&p->pos);
+    sqlite3_free(p->aEdge);
+    sqlite3_free(p->aSorted);
+    sqlite3_free(p->aEnd);
+    memset(p, 0, sizeof(*p));
+}
+
+/*
+** Return true if column iCol of the current row of pStmt is a number,
+** which is what an edge weight must be.
+*/
+static int bfsvtabIsNumber(sqlite3_stmt *pStmt, int iCol) {
+    int eType = sqlite3_column_type(pStmt, iCol);
+    return eType == SQLITE_INTEGER || eType == SQLITE_FLOAT;
+}
+
+/*****************************************************************************
+** In-memory adjacency (compressed sparse row) implementation
+*/
+/*
+** The cache of in-memory adjacencies that all the connections of the
+** process share (see "Shared adjacency" below).  It is defined here as
+** the adjacencies in it refer to its mutex.
+*/
+struct bfsvtab_shared {
+    int nRef;                   /* Number of connections using the cache */
+    sqlite3_mutex *mutex;       /* Guards everything below, see above */
+    bfsvtab_shared_entry *pEntry;   /* Entries, most recently used first */
+};
+
+/*
+** A snapshot of the whole edge relation in compressed sparse row form.
+** Every node id that appears in the from or to column is given a dense
+** index in the range 0..nNode-1.  The targets of the edges leaving the
+** node with index i are aTarget[aOffset[i]] through aTarget[aOffset[i+1]-1],
+** in the order in which the edge table returns them.  When the snapshot
+** is built with a weight column, aWeight[] holds the weight of each edge
+** in the same order.
+**
+** Once a snapshot is in the shared cache, other threads may hold
+** references to it, so nRef and the lazily built reverse arrays are only
+** changed while holding the cache's mutex, and nothing else is changed.
+*/
+struct bfsvtab_csr {
+    int nRef;                   /* Number of references to this object */
+    sqlite3_int64 nNode;        /* Number of distinct node ids */
+    sqlite3_int64 nEdge;        /* Number of edges */
+    sqlite3_int64 *aId;         /* Node id of each index */
+    sqlite3_int64 *aOffset;     /* nNode+1 offsets into aTarget[] */
+    unsigned int *aTarget;      /* Target index of each edge */
+    double *aWeight;            /* Weight of each edge, or NULL */
+    sqlite3_int64 *aRevOffset;  /* As aOffset[], for edges by target */
+    unsigned int *aRevSource;   /* Source index of each edge, by target */
+    bfsvtab_hash index;         /* Map from node id to index */
+    void *pMap;                 /* Mapped file holding the above, or NULL */
+    sqlite3_int64 nMap;         /* Size of the mapping in bytes */
+    bfsvtab_shared *pShared;    /* Shared cache that holds this, or NULL */
+};
+
+/*
+** Take another reference to a bfsvtab_csr object.
+*/
+static void bfsvtabCsrRef(bfsvtab_csr *p) {
+    sqlite3_mutex *pMutex = p->pShared ? p->pShared->mutex : 0;
+    sqlite3_mutex_enter(pMutex);
+    p->nRef++;
+    sqlite3_mutex_leave(pMutex);
+}
+
+/*
+** Drop a reference to a bfsvtab_csr object, freeing it and everything it
+** owns when the last reference goes away.
+*/
+static void bfsvtabCsrUnref(bfsvtab_csr *p) {
+    sqlite3_mutex *pMutex;
+    int nRef;
+    if (p == 0) {
+        return;
+    }
+    pMutex = p->pShared ? p->pShared->mutex : 0;
+    sqlite3_mutex_enter(pMutex);
+    nRef = --p->nRef;
+    sqlite3_mutex_leave(pMutex);
+    if (nRef <= 0) {
+        if (p->pMap == 0) {
+            sqlite3_free(p->aId);
+            sqlite3_free(p->aOffset);
+            sqlite3_free(p->aTarget);
+            sqlite3_free(p->aWeight);
+            bfsvtabHashClear(&p->index);
+        }
+#if BFSVTAB_MMAP
+        else {
+            munmap(p->pMap, (size_t)p->nMap);
+        }
+#endif
+        sqlite3_free(p->aRevOffset);
+        sqlite3_free(p->aRevSource);
+        sqlite3_free(p);
+    }
+}
+
+/*
+** Make sure aId[] and aOffset[] have room for at least nNode+1 entries.
+*/
+static int bfsvtabCsrReserveNodes(bfsvtab_csr *p, sqlite3_int64 *pnAlloc) {
+    sqlite3_int64 nNew;
+    sqlite3_int64 *aNew;
+    if (p->nNode + 1 < *pnAlloc) {
+        return SQLITE_OK;
+    }
+    nNew = *pnAlloc ? *pnAlloc * 2 : 1024;
+    aNew = sqlite3_realloc64(p->aId, nNew * sizeof(sqlite3_int64));
+    if (aNew == 0) {
+        return SQLITE_NOMEM;
+    }
+    p->aId = aNew;
+    aNew = sqlite3_realloc64(p->aOffset, nNew * sizeof(sqlite3_int64));
+    if (aNew == 0) {
+        return SQLITE_NOMEM;
+    }
+    p->aOffset = aNew;
+    *pnAlloc = nNew;
+    return SQLITE_OK;
+}
+
+/*
+** Return the index of node id, adding it to the snapshot as a node
+** without outgoing edges if it is not already there.
+*/
+static int bfsvtabCsrAddNode(
+    bfsvtab_csr *p,
+    sqlite3_int64 id,
+    sqlite3_int64 *pnAlloc,
+    sqlite3_int64 *piNode
+) {
+    int bNew;
+    int rc = bfsvtabHashInsert(&p->index, id, p->nNode, &bNew);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    if (bNew == 0) {
+        *piNode = bfsvtabHashSearch(&p->index, id)->value;
+        return SQLITE_OK;
+    }
+    rc = bfsvtabCsrReserveNodes(p, pnAlloc);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    p->aId[p->nNode] = id;
+    *piNode = p->nNode++;
+    return SQLITE_OK;
+}
+
+/*
+** Load the edge relation zTo(zFrom) of table zTable into a new
+** bfsvtab_csr object using a single scan of the form
+**
+**     SELECT from, to [, weight] FROM tablename ORDER BY from
+**
+** If bBoth is true, every edge is also loaded the other way round, with
+** a UNION ALL of the same scan with from and to swapped, so that the
+** snapshot holds the undirected graph.
+**
+** Rows whose from or to value is not an integer are ignored, just as
+** they are by the per-node lookup, and so are rows whose weight is not
+** a number when zWeight is not NULL.  On success, *ppCsr is set to the
+** new object holding one reference, which the caller must eventually
+** release with bfsvtabCsrUnref().
+*/
+static int bfsvtabCsrBuild(
+    sqlite3 *db,
+    const char *zTable,
+    const char *zFrom,
+    const char *zTo,
+    const char *zWeight,
+    int bBoth,
+    bfsvtab_csr **ppCsr
+) {
+    bfsvtab_csr *p;
+    sqlite3_stmt *pStmt = 0;
+    sqlite3_str *pStr;
+    char *zSql;
+    sqlite3_int64 *aTo = 0;         /* Target ids, in scan order */
+    sqlite3_int64 nToAlloc = 0;     /* Allocated size of aTo[] */
+    double *aWeight = 0;            /* Edge weights, in scan order */
+    sqlite3_int64 nNodeAlloc = 0;   /* Allocated size of aId[], aOffset[] */
+    sqlite3_int64 nFrom;            /* Number of nodes with outgoing edges */
+    sqlite3_int64 iFrom = 0;        /* From id of the previous row */
+    sqlite3_int64 i, iNode;
+    int rc;
+
+    *ppCsr = 0;
+    p = sqlite3_malloc(sizeof(*p));
+    if (p == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(p, 0, sizeof(*p));
+    p->nRef = 1;
+
+    pStr = sqlite3_str_new(db);
+    for (i = 0; i < (bBoth ? 2 : 1); i++) {
+        sqlite3_str_appendf(pStr, "%sSELECT \"%w\".\"%w\", \"%w\".\"%w\"",
+            i ? " UNION ALL " : "",
+            zTable, i ? zTo : zFrom, zTable, i ? zFrom : zTo);
+        if (zWeight) {
+            sqlite3_str_appendf(pStr, ", \"%w\".\"%w\"", zTable, zWeight);
+        }
+        sqlite3_str_appendf(pStr, " FROM \"%w\"", zTable);
+    }
+    sqlite3_str_appendall(pStr, " ORDER BY 1");
+    zSql = sqlite3_str_finish(pStr);
+    if (zSql == 0) {
+        rc = SQLITE_NOMEM;
+        goto csrBuildError;
+    }
+    rc = sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0);
+    sqlite3_free(zSql);
+    if (rc != SQLITE_OK) {
+        goto csrBuildError;
+    }
+
+    /* The rows arrive grouped by from id, so each group is given the next
+    ** index and its edges are appended to aTo[].  Target ids are turned
+    ** into indices once every node with outgoing edges has one.  */
+    while (sqlite3_step(pStmt) == SQLITE_ROW) {
+        sqlite3_int64 iRowFrom;
+        if (sqlite3_column_type(pStmt, 0) != SQLITE_INTEGER
+            || sqlite3_column_type(pStmt, 1) != SQLITE_INTEGER
+            || (zWeight && bfsvtabIsNumber(pStmt, 2) == 0)) {
+            continue;
+        }
+        iRowFrom = sqlite3_column_int64(pStmt, 0);
+        if (p->nNode == 0 || iRowFrom != iFrom) {
+            rc = bfsvtabCsrAddNode(p, iRowFrom, &nNodeAlloc, &iNode);
+            if (rc != SQLITE_OK) {
+                goto csrBuildError;
+            }
+            p->aOffset[iNode] = p->nEdge;
+            iFrom = iRowFrom;
+        }
+        if (p->nEdge >= nToAlloc) {
+            sqlite3_int64 nNew = nToAlloc ? nToAlloc * 2 : 4096;
+            sqlite3_int64 *aNew;
+            aNew = sqlite3_realloc64(aTo, nNew * sizeof(sqlite3_int64));
+            if (aNew == 0) {
+                rc = SQLITE_NOMEM;
+                goto csrBuildError;
+            }
+            aTo = aNew;
+            if (zWeight) {
+                double *aNewWeight = sqlite3_realloc64(aWeight, nNew * sizeof(double));
+                if (aNewWeight == 0) {
+                    rc = SQLITE_NOMEM;
+                    goto csrBuildError;
+                }
+                aWeight = aNewWeight;
+            }
+            nToAlloc = nNew;
+        }
+        if (zWeight) {
+            aWeight[p->nEdge] = sqlite3_column_double(pStmt, 2);
+        }
+        aTo[p->nEdge++] = sqlite3_column_int64(pStmt, 1);
+    }
+    rc = sqlite3_finalize(pStmt);
+    pStmt = 0;
+    if (rc != SQLITE_OK) {
+        goto csrBuildError;
+    }
+
+    nFrom = p->nNode;
+    p->aTarget = sqlite3_malloc64((p->nEdge ? p->nEdge : 1) * sizeof(unsigned int));
+    if (p->aTarget == 0) {
+        rc = SQLITE_NOMEM;
+        goto csrBuildError;
+    }
+    for (i = 0; i < p->nEdge; i++) {
+        rc = bfsvtabCsrAddNode(p, aTo[i], &nNodeAlloc, &iNode);
+        if (rc != SQLITE_OK) {
+            goto csrBuildError;
+        }
+        if (iNode > 0xffffffff) {
+            rc = SQLITE_TOOBIG;
+            goto csrBuildError;
+        }
+        p->aTarget[i] = (unsigned int)iNode;
+    }
+    rc = bfsvtabCsrReserveNodes(p, &nNodeAlloc);
+    if (rc != SQLITE_OK) {
+        goto csrBuildError;
+    }
+    for (i = nFrom; i <= p->nNode; i++) {
+        p->aOffset[i] = p->nEdge;
+    }
+    sqlite3_free(aTo);
+    p->aWeight = aWeight;
+    *ppCsr = p;
+    return SQLITE_OK;
+
+csrBuildError:
+    sqlite3_finalize(pStmt);
+    sqlite3_free(aTo);
+    sqlite3_free(aWeight);
+    bfsvtabCsrUnref(p);
+    return rc;
+}
+
+/*
+** Build the reverse adjacency of p, if it has not been built already:
+** aRevSource[aRevOffset[i]] through aRevSource[aRevOffset[i+1]-1] are
+** the sources of the edges that arrive at the node with index i, in
+** order of source index.
+*/
+static int bfsvtabCsrReverse(bfsvtab_csr *p) {
+    sqlite3_mutex *pMutex = p->pShared ? p->pShared->mutex : 0;
+    sqlite3_int64 i, j;
+    sqlite3_mutex_enter(pMutex);
+    if (p->aRevOffset) {
+        sqlite3_mutex_leave(pMutex);
+        return SQLITE_OK;
+    }
+    p->aRevOffset = sqlite3_malloc64((p->nNode + 1) * sizeof(sqlite3_int64));
+    p->aRevSource = sqlite3_malloc64((p->nEdge ? p->nEdge : 1) * sizeof(unsigned int));
+    if (p->aRevOffset == 0 || p->aRevSource == 0) {
+        sqlite3_free(p->aRevOffset);
+        sqlite3_free(p->aRevSource);
+        p->aRevOffset = 0;
+        p->aRevSource = 0;
+        sqlite3_mutex_leave(pMutex);
+        return SQLITE_NOMEM;
+    }
+    /* Count the edges arriving at each node, turn the counts into the end
+    ** of each node's list, then fill every list from the back, visiting
+    ** sources in descending order. Each aRevOffset[i] then ends up at the
+    ** start of its list, with the sources in ascending order. */
+    memset(p->aRevOffset, 0, (p->nNode + 1) * sizeof(sqlite3_int64));
+    for (i = 0; i < p->nEdge; i++) {
+        p->aRevOffset[p->aTarget[i]]++;
+    }
+    for (i = 1; i < p->nNode; i++) {
+        p->aRevOffset[i] += p->aRevOffset[i - 1];
+    }
+    p->aRevOffset[p->nNode] = p->nEdge;
+    for (i = p->nNode - 1; i >= 0; i--) {
+        for (j = p->aOffset[i + 1] - 1; j >= p->aOffset[i]; j--) {
+            p->aRevSource[--p->aRevOffset[p->aTarget[j]]] = (unsigned int)i;
+        }
+    }
+    sqlite3_mutex_leave(pMutex);
+    return SQLITE_OK;
+}
+
+/*
+** A change to one edge of the relation, as logged for an incremental
+** refresh of a cached adjacency.
+*/
+struct bfsvtab_delta {
+    sqlite3_int64 iFrom;        /* From node id, or index once resolved */
+    sqlite3_int64 iTo;          /* To node id, or index once resolved */
+    sqlite3_int64 iSeq;         /* Position among the changes */
+    double rWeight;             /* Weight of the edge, if weighted */
+    int bInsert;                /* True if the edge was added, not removed */
+};
+
+/*
+** Compare two bfsvtab_delta objects by from node, then by position, so
+** that qsort() keeps the changes to each node in the order they were made.
+*/
+static int bfsvtabDeltaCompare(const void *pA, const void *pB) {
+    const bfsvtab_delta *a = (const bfsvtab_delta*)pA;
+    const bfsvtab_delta *b = (const bfsvtab_delta*)pB;
+    if (a->iFrom != b->iFrom) {
+        return a->iFrom < b->iFrom ? -1 : 1;
+    }
+    return a->iSeq < b->iSeq ? -1 : a->iSeq > b->iSeq;
+}
+
+/*
+** Apply the nDelta changes of aDelta[], given by node id in the order in
+** which they were made, to the adjacency pOld and set *ppCsr to the
+** result.  If bBoth is true each change applies to the edge both ways,
+** as bfsvtabCsrBuild() loads it.
+**
+** An added edge goes after the other edges of its from node, which is
+** where a scan of the edge table in rowid order usually returns it.  A
+** removed edge takes out the first edge with the same target (and weight).
+** New node ids are given the next indices.  A node left without edges
+** keeps its index, which makes no difference to a traversal.
+**
+** The nodes whose edges did not change are moved in runs with memcpy(),
+** so the cost is a copy of the arrays plus a sort of the changes, with
+** no scan of the edge table.
+**
+** The caller's reference to pOld is consumed.  If it was the only one,
+** and pOld is neither mapped from a file nor shared, pOld is updated in
+** place.  Otherwise the result is a copy, so that the cursors still using
+** pOld are not disturbed.  On error, *ppCsr is NULL.
+*/
+static int bfsvtabCsrPatch(
+    bfsvtab_csr *pOld,
+    const bfsvtab_delta *aDelta,
+    sqlite3_int64 nDelta,
+    int bBoth,
+    bfsvtab_csr **ppCsr
+) {
+    bfsvtab_csr *p = pOld;
+    sqlite3_int64 nOldNode = pOld->nNode;
+    bfsvtab_delta *aEdge = 0;       /* The changes by node index, sorted */
+    sqlite3_int64 nEdge = 0;        /* Number of entries in aEdge[] */
+    sqlite3_int64 nInsert = 0;      /* Number of added edges in aEdge[] */
+    sqlite3_int64 *aOffset = 0;
+    unsigned int *aTarget = 0;
+    double *aWeight = 0;
+    sqlite3_int64 *aId;
+    sqlite3_int64 i, j, k, iOut;
+    int rc = SQLITE_OK;
+
+    *ppCsr = 0;
+    if (pOld->pShared || pOld->nRef > 1 || pOld->pMap) {
+        p = sqlite3_malloc(sizeof(*p));
+        if (p == 0) {
+            bfsvtabCsrUnref(pOld);
+            return SQLITE_NOMEM;
+        }
+        memset(p, 0, sizeof(*p));
+        p->nRef = 1;
+        p->aId = sqlite3_malloc64((nOldNode ? nOldNode : 1) * sizeof(sqlite3_int64));
+        if (p->aId == 0) {
+            rc = SQLITE_NOMEM;
+            goto csrPatchError;
+        }
+        memcpy(p->aId, pOld->aId, nOldNode * sizeof(sqlite3_int64));
+        for (p->nNode = 0; p->nNode < nOldNode; p->nNode++) {
+            int bNew;
+            rc = bfsvtabHashInsert(&p->index, p->aId[p->nNode], p->nNode, &bNew);
+            if (rc != SQLITE_OK) {
+                goto csrPatchError;
+            }
+        }
+    }
+
+    /* Each change adds at most two node ids */
+    aId = sqlite3_realloc64(p->aId, (nOldNode + 2 * nDelta + 1) * sizeof(sqlite3_int64));
+    aEdge = sqlite3_malloc64((nDelta ? nDelta : 1) * (bBoth ? 2 : 1) * sizeof(bfsvtab_delta));
+    if (aId == 0 || aEdge == 0) {
+        rc = SQLITE_NOMEM;
+        goto csrPatchError;
+    }
+    p->aId = aId;
+    for (i = 0; i < nDelta; i++) {
+        for (k = 0; k < (bBoth ? 2 : 1); k++) {
+            sqlite3_int64 aNode[2];
+            sqlite3_int64 aKey[2];
+            aNode[0] = k ? aDelta[i].iTo : aDelta[i].iFrom;
+            aNode[1] = k ? aDelta[i].iFrom : aDelta[i].iTo;
+            for (j = 0; j < 2; j++) {
+                bfsvtab_hash_entry *pEntry = bfsvtabHashSearch(&p->index, aNode[j]);
+                int bNew;
+                if (pEntry) {
+                    aKey[j] = pEntry->value;
+                    continue;
+                }
+                if (aDelta[i].bInsert == 0) {
+                    /* No edge to or from an unknown node was loaded */
+                    break;
+                }
+                rc = bfsvtabHashInsert(&p->index, aNode[j], p->nNode, &bNew);
+                if (rc != SQLITE_OK) {
+                    goto csrPatchError;
+                }
+                p->aId[p->nNode] = aNode[j];
+                aKey[j] = p->nNode++;
+            }
+            if (j < 2) {
+                continue;
+            }
+            if (aKey[1] > 0xffffffff) {
+                rc = SQLITE_TOOBIG;
+                goto csrPatchError;
+            }
+            aEdge[nEdge] = aDelta[i];
+            aEdge[nEdge].iFrom = aKey[0];
+            aEdge[nEdge].iTo = aKey[1];
+            aEdge[nEdge].iSeq = nEdge;
+            nInsert += aEdge[nEdge].bInsert != 0;
+            nEdge++;
+        }
+    }
+    qsort(aEdge, (size_t)nEdge, sizeof(bfsvtab_delta), bfsvtabDeltaCompare);
+
+    aOffset = sqlite3_malloc64((p->nNode + 1) * sizeof(sqlite3_int64));
+    aTarget = sqlite3_malloc64((pOld->nEdge + nInsert + 1) * sizeof(unsigned int));
+    if (pOld->aWeight) {
+        aWeight = sqlite3_malloc64((pOld->nEdge + nInsert + 1) * sizeof(double));
+    }
+    if (aOffset == 0 || aTarget == 0 || (pOld->aWeight && aWeight == 0)) {
+        rc = SQLITE_NOMEM;
+        goto csrPatchError;
+    }
+    iOut = 0;
+    k = 0;
+    i = 0;
+    while (i < p->nNode) {
+        sqlite3_int64 iNext = k < nEdge ? aEdge[k].iFrom : p->nNode;
+        sqlite3_int64 iEnd = iNext < nOldNode ? iNext : nOldNode;
+        sqlite3_int64 iStart;
+
+        /* Move the unchanged nodes before iNext in one run */
+        if (i < iEnd) {
+            sqlite3_int64 iFirst = pOld->aOffset[i];
+            sqlite3_int64 n = pOld->aOffset[iEnd] - iFirst;
+            memcpy(&aTarget[iOut], &pOld->aTarget[iFirst], n * sizeof(unsigned int));
+            if (aWeight) {
+                memcpy(&aWeight[iOut], &pOld->aWeight[iFirst], n * sizeof(double));
+            }
+            for (; i < iEnd; i++) {
+                aOffset[i] = pOld->aOffset[i] - iFirst + iOut;
+            }
+            iOut += n;
+        }
+        for (; i < iNext; i++) {
+            aOffset[i] = iOut;
+        }
+        if (i == p->nNode) {
+            break;
+        }
+
+        /* Node i has changes.  Copy its edges, then replay the changes */
+        iStart = iOut;
+        if (i < nOldNode) {
+            sqlite3_int64 iFirst = pOld->aOffset[i];
+            sqlite3_int64 n = pOld->aOffset[i + 1] - iFirst;
+            memcpy(&aTarget[iOut], &pOld->aTarget[iFirst], n * sizeof(unsigned int));
+            if (aWeight) {
+                memcpy(&aWeight[iOut], &pOld->aWeight[iFirst], n * sizeof(double));
+            }
+            iOut += n;
+        }
+        for (; k < nEdge && aEdge[k].iFrom == i; k++) {
+            if (aEdge[k].bInsert) {
+                aTarget[iOut] = (unsigned int)aEdge[k].iTo;
+                if (aWeight) {
+                    aWeight[iOut] = aEdge[k].rWeight;
+                }
+                iOut++;
+                continue;
+            }
+            for (j = iStart; j < iOut; j++) {
+                if (aTarget[j] == aEdge[k].iTo
+                    && (aWeight == 0 || aWeight[j] == aEdge[k].rWeight)) {
+                    memmove(&aTarget[j], &aTarget[j + 1],
+                            (iOut - j - 1) * sizeof(unsigned int));
+                    if (aWeight) {
+                        memmove(&aWeight[j], &aWeight[j + 1],
+                                (iOut - j - 1) * sizeof(double));
+                    }
+                    iOut--;
+                    break;
+                }
+            }
+        }
+        aOffset[i++] = iStart;
+    }
+    aOffset[p->nNode] = iOut;
+    sqlite3_free(aEdge);
+
+    if (p == pOld) {
+        sqlite3_free(p->aOffset);
+        sqlite3_free(p->aTarget);
+        sqlite3_free(p->aWeight);
+        sqlite3_free(p->aRevOffset);
+        sqlite3_free(p->aRevSource);
+        p->aRevOffset = 0;
+        p->aRevSource = 0;
+    } else {
+        bfsvtabCsrUnref(pOld);
+    }
+    p->aOffset = aOffset;
+    p->aTarget = aTarget;
+    p->aWeight = aWeight;
+    p->nEdge = iOut;
+    *ppCsr = p;
+    return SQLITE_OK;
+
+csrPatchError:
+    sqlite3_free(aEdge);
+    sqlite3_free(aOffset);
+    sqlite3_free(aTarget);
+    sqlite3_free(aWeight);
+    if (p != pOld) {
+        bfsvtabCsrUnref(p);
+    }
+    bfsvtabCsrUnref(pOld);
+    return rc;
+}
+
+/*
+** End of the in-memory adjacency implementation
+******************************************************************************/
+
+/******************************************************************************
+** Direction-optimizing traversal
+**
+** The traversal proceeds a whole level at a time.  A top-down step scans
+** the edges out of every node of the current level for unvisited nodes.
+** A bottom-up step instead scans the edges into every unvisited node for
+** one that starts in the current level, and stops at the first it finds.
+** Once the level holds a good part of the graph, most unvisited nodes
+** find a parent after checking only a few edges, so bottom-up steps
+** inspect far fewer edges than top-down ones.
+**
+** The choice between the two follows Beamer, Asanovic and Patterson,
+** "Direction-Optimizing Breadth-First Search": switch to bottom-up once
+** the edges out of the level exceed 1/ALPHA of the edges into unvisited
+** nodes, and back to top-down once the level holds fewer than 1/BETA of
+** all nodes.
+**
+** Nodes are identified by their index in a bfsvtab_csr, with keys from
+** nNode up standing for roots that have no edges.
+*/
+#define BFSVTAB_DIROPT_ALPHA 14
+#define BFSVTAB_DIROPT_BETA  24
+
+/*
+** A step is shared between at most BFSVTAB_MAX_THREADS threads, each of
+** which is given at least BFSVTAB_THREAD_WORK level entries (top-down)
+** or nodes (bottom-up) to look at.
+*/
+#define BFSVTAB_MAX_THREADS  64
+#ifndef BFSVTAB_THREAD_WORK
+# define BFSVTAB_THREAD_WORK 4096
+#endif
+
+struct bfsvtab_diropt {
+    sqlite3_int64 nKey;         /* Number of keys in aParent[] or aSeen[] */
+    sqlite3_int64 *aParent;     /* Parent key of each node, or -1, or NULL */
+    sqlite3_uint64 *aSeen;      /* Bitmap of visited nodes, if no aParent[] */
+    sqlite3_uint64 *aFrontier;  /* Bitmap of the nodes in level */
+    bfsvtab_keys level;         /* Nodes at distance iDistance */
+    bfsvtab_keys next;          /* Scratch space for the next level */
+    sqlite3_int64 iPos;         /* Index in level of the next node to return */
+    sqlite3_int64 iDistance;    /* Distance of the nodes in level */
+    sqlite3_int64 nEdgeLevel;   /* Number of edges out of the nodes in level */
+    sqlite3_int64 nEdgeLeft;    /* Number of edges into unvisited nodes */
+    int bBottomUp;              /* True while taking bottom-up steps */
+    int nThread;                /* Maximum number of threads per step */
+    sqlite3_uint64 *aRank;      /* Rank of best edge to each node (threads) */
+};
+
+/*
+** Free a bfsvtab_diropt object.
+*/
+static void bfsvtabDiroptFree(bfsvtab_diropt *p) {
+    if (p) {
+        sqlite3_free(p->aParent);
+        sqlite3_free(p->aSeen);
+        sqlite3_free(p->aFrontier);
+        sqlite3_free(p->aRank);
+        bfsvtabKeysClear(&p->level);
+        bfsvtabKeysClear(&p->next);
+        sqlite3_free(p);
+    }
+}
+
+/*
+** Return true if node iKey of a bfsvtab_diropt traversal has been visited.
+*/
+static int bfsvtabDiroptSeen(const bfsvtab_diropt *p, sqlite3_int64 iKey) {
+    if (p->aParent) {
+        return p->aParent[iKey] >= 0;
+    }
+    return (p->aSeen[iKey / 64] >> (iKey % 64)) & 1;
+}
+
+/*
+** Mark node iKey of a bfsvtab_diropt traversal visited from node iParent.
+*/
+static void bfsvtabDiroptMark(
+    bfsvtab_diropt *p,
+    sqlite3_int64 iKey,
+    sqlite3_int64 iParent
+) {
+    if (p->aParent) {
+        p->aParent[iKey] = iParent;
+    } else {
+        p->aSeen[iKey / 64] |= ((sqlite3_uint64)1) << (iKey % 64);
+    }
+}
+
+/*
+** Allocate a bfsvtab_diropt for a traversal of pCsr over nKey keys,
+** starting at the nRoot distinct nodes in aRoot[], which make up the first
+** level.  The reverse adjacency of pCsr must already have been built.
+** Unless bParent is true, the parent of each node is not kept, and a
+** bitmap of the visited nodes takes the place of aParent[].
+*/
+static int bfsvtabDiroptNew(
+    bfsvtab_csr *pCsr,
+    sqlite3_int64 nKey,
+    const sqlite3_int64 *aRoot,
+    sqlite3_int64 nRoot,
+    int nThread,
+    int bParent,
+    bfsvtab_diropt **ppOut
+) {
+    sqlite3_int64 nWord = (nKey + 63) / 64;
+    bfsvtab_diropt *p;
+    sqlite3_int64 i;
+    int rc;
+
+    *ppOut = 0;
+    p = sqlite3_malloc(sizeof(*p));
+    if (p == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(p, 0, sizeof(*p));
+    p->nKey = nKey;
+    if (bParent) {
+        p->aParent = sqlite3_malloc64(nKey * sizeof(sqlite3_int64));
+    } else {
+        p->aSeen = sqlite3_malloc64(nWord * sizeof(sqlite3_uint64));
+    }
+    p->aFrontier = sqlite3_malloc64(nWord * sizeof(sqlite3_uint64));
+    if ((p->aParent == 0 && p->aSeen == 0) || p->aFrontier == 0) {
+        bfsvtabDiroptFree(p);
+        return SQLITE_NOMEM;
+    }
+    if (p->aSeen) {
+        memset(p->aSeen, 0, nWord * sizeof(sqlite3_uint64));
+    }
+    for (i = 0; p->aParent && i < nKey; i++) {
+        p->aParent[i] = -1;
+    }
+    if (BFSVTAB_THREADS && nThread > 1) {
+        p->nThread = nThread > BFSVTAB_MAX_THREADS ? BFSVTAB_MAX_THREADS : nThread;
+        p->aRank = sqlite3_malloc64(nKey * sizeof(sqlite3_uint64));
+        if (p->aRank == 0) {
+            bfsvtabDiroptFree(p);
+            return SQLITE_NOMEM;
+        }
+        memset(p->aRank, 0xff, nKey * sizeof(sqlite3_uint64));
+    }
+    p->nEdgeLeft = pCsr->nEdge;
+    for (i = 0; i < nRoot; i++) {
+        sqlite3_int64 iRoot = aRoot[i];
+        bfsvtabDiroptMark(p, iRoot, iRoot);
+        rc = bfsvtabKeysAppend(&p->level, iRoot);
+        if (rc != SQLITE_OK) {
+            bfsvtabDiroptFree(p);
+            return rc;
+        }
+        if (iRoot < pCsr->nNode) {
+            p->nEdgeLevel += pCsr->aOffset[iRoot + 1] - pCsr->aOffset[iRoot];
+            p->nEdgeLeft -= pCsr->aRevOffset[iRoot + 1] - pCsr->aRevOffset[iRoot];
+        }
+    }
+    *ppOut = p;
+    return SQLITE_OK;
+}
+
+/*
+** Mark node iKey, reached from node iParent, visited and add it to the
+** next level.
+*/
+static int bfsvtabDiroptVisit(
+    bfsvtab_diropt *p,
+    bfsvtab_csr *pCsr,
+    sqlite3_int64 iKey,
+    sqlite3_int64 iParent
+) {
+    bfsvtabDiroptMark(p, iKey, iParent);
+    p->nEdgeLevel += pCsr->aOffset[iKey + 1] - pCsr->aOffset[iKey];
+    p->nEdgeLeft -= pCsr->aRevOffset[iKey + 1] - pCsr->aRevOffset[iKey];
+    return bfsvtabKeysAppend(&p->next, iKey);
+}
+
+#if BFSVTAB_THREADS
+/*
+** One thread's share of a step of a bfsvtab_diropt traversal.
+*/
+typedef struct bfsvtab_worker bfsvtab_worker;
+struct bfsvtab_worker {
+    bfsvtab_diropt *p;          /* The traversal */
+    bfsvtab_csr *pCsr;          /* Its adjacency */
+    sqlite3_int64 iBegin;       /* First level entry or node to look at */
+    sqlite3_int64 iEnd;         /* One past the last */
+    bfsvtab_keys found;         /* Nodes found, in malloc()'d memory */
+    int rc;                     /* SQLITE_OK, or an error code */
+    pthread_t thread;           /* The thread, if one was started */
+    int bStarted;               /* True if thread was started */
+};
+
+/*
+** Append iKey to the nodes found by worker w.  Workers may run while the
+** SQLite allocator is not safe to call from other threads (for example
+** in a SQLITE_THREADSAFE=0 build), so this uses the system allocator.
+*/
+static void bfsvtabWorkerFound(bfsvtab_worker *w, sqlite3_int64 iKey) {
+    bfsvtab_keys *p = &w->found;
+    if (p->n >= p->nAlloc) {
+        sqlite3_int64 nNew = p->nAlloc ? p->nAlloc * 2 : 64;
+        sqlite3_int64 *aNew = realloc(p->a, nNew * sizeof(sqlite3_int64));
+        if (aNew == 0) {
+            w->rc = SQLITE_NOMEM;
+            return;
+        }
+        p->a = aNew;
+        p->nAlloc = nNew;
+    }
+    p->a[p->n++] = iKey;
+}
+
+/*
+** A node found by a top-down step, and the rank of its parent edge.
+*/
+typedef struct bfsvtab_ranked bfsvtab_ranked;
+struct bfsvtab_ranked {
+    sqlite3_uint64 rank;
+    sqlite3_int64 iKey;
+};
+
+static int bfsvtabRankedCmp(const void *pA, const void *pB) {
+    sqlite3_uint64 a = ((const bfsvtab_ranked*)pA)->rank;
+    sqlite3_uint64 b = ((const bfsvtab_ranked*)pB)->rank;
+    return a < b ? -1 : a > b;
+}
+
+/*
+** Do one worker's share of a step.  A bottom-up step is split by node, so
+** each node's parent is written by exactly one worker.  A top-down step is
+** split by level entry, and several workers may find the same node.  The
+** edges are ranked by the position of their source in the level and then
+** by their position among its edges, which is the order a single thread
+** would scan them in.  Each node keeps the lowest rank of any edge to it,
+** using compare-and-swap, and is reported by the worker that reached it
+** first.  The parents are filled in from the ranks once all are done.
+*/
+static void *bfsvtabWorkerMain(void *pArg) {
+    bfsvtab_worker *w = (bfsvtab_worker*)pArg;
+    bfsvtab_diropt *p = w->p;
+    bfsvtab_csr *pCsr = w->pCsr;
+    sqlite3_int64 i, j, iKey;
+
+    if (p->bBottomUp) {
+        for (iKey = w->iBegin; w->rc == SQLITE_OK && iKey < w->iEnd; iKey++) {
+            if (bfsvtabDiroptSeen(p, iKey)) {
+                continue;
+            }
+            for (j = pCsr->aRevOffset[iKey]; j < pCsr->aRevOffset[iKey + 1]; j++) {
+                unsigned int iFrom = pCsr->aRevSource[j];
+                if (p->aFrontier[iFrom / 64] & (((sqlite3_uint64)1) << (iFrom % 64))) {
+                    /* Workers share the words of aSeen[], so its bits are
+                    ** only set once they are done */
+                    if (p->aParent) {
+                        p->aParent[iKey] = iFrom;
+                    }
+                    bfsvtabWorkerFound(w, iKey);
+                    break;
+                }
+            }
+        }
+        return 0;
+    }
+    for (i = w->iBegin; w->rc == SQLITE_OK && i < w->iEnd; i++) {
+        iKey = p->level.a[i];
+        if (iKey >= pCsr->nNode) {
+            continue;
+        }
+        for (j = pCsr->aOffset[iKey]; w->rc == SQLITE_OK && j < pCsr->aOffset[iKey + 1]; j++) {
+            unsigned int iTo = pCsr->aTarget[j];
+            sqlite3_uint64 rank;
+            sqlite3_uint64 old;
+            if (bfsvtabDiroptSeen(p, iTo)) {
+                continue;
+            }
+            rank = j - pCsr->aOffset[iKey];
+            if (rank > 0xffffffff) {
+                rank = 0xffffffff;
+            }
+            rank |= ((sqlite3_uint64)i) << 32;
+            old = __atomic_load_n(&p->aRank[iTo], __ATOMIC_RELAXED);
+            while (rank < old) {
+                if (__atomic_compare_exchange_n(&p->aRank[iTo], &old, rank, 0,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    if (old == ~(sqlite3_uint64)0) {
+                        bfsvtabWorkerFound(w, iTo);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+** Take the current step of p using nWorker threads (one of them the
+** calling thread), leaving the next level in p->next in the same order,
+** and with the same parents, as a single thread would.
+*/
+static int bfsvtabDiroptParallel(
+    bfsvtab_diropt *p,
+    bfsvtab_csr *pCsr,
+    int nWorker
+) {
+    bfsvtab_worker *aWorker;
+    bfsvtab_ranked *aRanked = 0;
+    sqlite3_int64 n = p->bBottomUp ? pCsr->nNode : p->level.n;
+    sqlite3_int64 i, iKey;
+    int rc = SQLITE_OK;
+    int k;
+
+    aWorker = sqlite3_malloc64(nWorker * sizeof(bfsvtab_worker));
+    if (aWorker == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(aWorker, 0, nWorker * sizeof(bfsvtab_worker));
+    for (k = 0; k < nWorker; k++) {
+        aWorker[k].p = p;
+        aWorker[k].pCsr = pCsr;
+        aWorker[k].iBegin = n * k / nWorker;
+        aWorker[k].iEnd = n * (k + 1) / nWorker;
+    }
+    for (k = 1; k < nWorker; k++) {
+        aWorker[k].bStarted = pthread_create(&aWorker[k].thread, 0,
+                bfsvtabWorkerMain, &aWorker[k]) == 0;
+    }
+    bfsvtabWorkerMain(&aWorker[0]);
+    for (k = 1; k < nWorker; k++) {
+        if (aWorker[k].bStarted) {
+            pthread_join(aWorker[k].thread, 0);
+        } else {
+            /* Could not start a thread.  Do its share here instead. */
+            bfsvtabWorkerMain(&aWorker[k]);
+        }
+    }
+
+    for (k = 0; k < nWorker; k++) {
+        if (rc == SQLITE_OK) {
+            rc = aWorker[k].rc;
+        }
+        for (i = 0; rc == SQLITE_OK && i < aWorker[k].found.n; i++) {
+            rc = bfsvtabKeysAppend(&p->next, aWorker[k].found.a[i]);
+        }
+        free(aWorker[k].found.a);
+    }
+    sqlite3_free(aWorker);
+
+    if (rc == SQLITE_OK && p->bBottomUp == 0 && p->next.n > 0) {
+        aRanked = sqlite3_malloc64(p->next.n * sizeof(bfsvtab_ranked));
+        if (aRanked == 0) {
+            rc = SQLITE_NOMEM;
+        } else {
+            for (i = 0; i < p->next.n; i++) {
+                aRanked[i].rank = p->aRank[p->next.a[i]];
+                aRanked[i].iKey = p->next.a[i];
+            }
+            qsort(aRanked, p->next.n, sizeof(bfsvtab_ranked), bfsvtabRankedCmp);
+            for (i = 0; i < p->next.n; i++) {
+                iKey = aRanked[i].iKey;
+                p->next.a[i] = iKey;
+                bfsvtabDiroptMark(p, iKey, p->level.a[aRanked[i].rank >> 32]);
+            }
+            sqlite3_free(aRanked);
+        }
+    }
+    for (i = 0; rc == SQLITE_OK && i < p->next.n; i++) {
+        iKey = p->next.a[i];
+        if (p->bBottomUp && p->aSeen) {
+            bfsvtabDiroptMark(p, iKey, 0);
+        }
+        p->nEdgeLevel += pCsr->aOffset[iKey + 1] - pCsr->aOffset[iKey];
+        p->nEdgeLeft -= pCsr->aRevOffset[iKey + 1] - pCsr->aRevOffset[iKey];
+    }
+    return rc;
+}
+#endif /* BFSVTAB_THREADS */
+
+/*
+** Replace the current level with the one after it.  The new level is
+** empty if no more nodes can be reached.
+*/
+static int bfsvtabDiroptStep(bfsvtab_diropt *p, bfsvtab_csr *pCsr) {
+    sqlite3_int64 i, j, iKey;
+    bfsvtab_keys tmp;
+    int rc = SQLITE_OK;
+
+    if (p->bBottomUp) {
+        if (p->level.n < pCsr->nNode / BFSVTAB_DIROPT_BETA) {
+            p->bBottomUp = 0;
+        }
+    } else if (p->nEdgeLevel > p->nEdgeLeft / BFSVTAB_DIROPT_ALPHA) {
+        p->bBottomUp = 1;
+    }
+
+    p->next.n = 0;
+    p->nEdgeLevel = 0;
+    if (p->bBottomUp) {
+        memset(p->aFrontier, 0, ((p->nKey + 63) / 64) * sizeof(sqlite3_uint64));
+        for (i = 0; i < p->level.n; i++) {
+            iKey = p->level.a[i];
+            p->aFrontier[iKey / 64] |= ((sqlite3_uint64)1) << (iKey % 64);
+        }
+    }
+#if BFSVTAB_THREADS
+    if (p->nThread > 1
+        && (p->bBottomUp ? pCsr->nNode : p->level.n) >= 2 * BFSVTAB_THREAD_WORK) {
+        sqlite3_int64 nWork = p->bBottomUp ? pCsr->nNode : p->level.n;
+        int nWorker = nWork / BFSVTAB_THREAD_WORK < p->nThread ?
+                (int)(nWork / BFSVTAB_THREAD_WORK) : p->nThread;
+        rc = bfsvtabDiroptParallel(p, pCsr, nWorker);
+    } else
+#endif
+    if (p->bBottomUp) {
+        for (iKey = 0; rc == SQLITE_OK && iKey < pCsr->nNode; iKey++) {
+            if (bfsvtabDiroptSeen(p, iKey)) {
+                continue;
+            }
+            for (j = pCsr->aRevOffset[iKey]; j < pCsr->aRevOffset[iKey + 1]; j++) {
+                unsigned int iFrom = pCsr->aRevSource[j];
+                if (p->aFrontier[iFrom / 64] & (((sqlite3_uint64)1) << (iFrom % 64))) {
+                    rc = bfsvtabDiroptVisit(p, pCsr, iKey, iFrom);
+                    break;
+                }
+            }
+        }
+    } else {
+        for (i = 0; rc == SQLITE_OK && i < p->level.n; i++) {
+            iKey = p->level.a[i];
+            if (iKey >= pCsr->nNode) {
+                continue;
+            }
+            for (j = pCsr->aOffset[iKey]; rc == SQLITE_OK && j < pCsr->aOffset[iKey + 1]; j++) {
+                if (!bfsvtabDiroptSeen(p, pCsr->aTarget[j])) {
+                    rc = bfsvtabDiroptVisit(p, pCsr, pCsr->aTarget[j], iKey);
+                }
+            }
+        }
+    }
+
+    tmp = p->level;
+    p->level = p->next;
+    p->next = tmp;
+    p->iPos = 0;
+    p->iDistance++;
+    return rc;
+}
+
+/*
+** End of the direction-optimizing traversal
+******************************************************************************/
+
+/******************************************************************************
+** Multi-source traversal
+**
+** Up to 64 roots are searched together, after Then et al., "The More the
+** Merrier: Efficient Multi-Source Graph Traversal".  For each node there
+** is a 64-bit word per level, whose bit i is set if the node is at that
+** distance from the i-th root of the batch.  One pass over the edges out
+** of a level then advances all of the traversals at once, and nodes that
+** are shared between them are only expanded once.
+**
+** Nodes are identified by their index in a bfsvtab_csr, as for the
+** direction-optimizing traversal.
+*/
+#define BFSVTAB_MSBFS_WIDTH 64
+
+struct bfsvtab_msbfs {
+    sqlite3_int64 nKey;         /* Number of keys in each array */
+    sqlite3_uint64 *aSeen;      /* Roots that have reached each node */
+    sqlite3_uint64 *aPrev;      /* Roots that reached each node at iDistance-1 */
+    sqlite3_uint64 *aCur;       /* Roots that reached each node at iDistance */
+    bfsvtab_keys prev;          /* Nodes with a bit set in aPrev */
+    bfsvtab_keys level;         /* Nodes with a bit set in aCur */
+    sqlite3_int64 iDistance;    /* Distance of the nodes in level */
+    sqlite3_int64 iPos;         /* Index in level of the next node to return */
+    sqlite3_uint64 mLeft;       /* Bits of level.a[iPos-1] not yet returned */
+    int iBit;                   /* Bit of the current row */
+    sqlite3_int64 iBase;        /* Index in the cursor roots of bit 0 */
+    sqlite3_int64 nPair;        /* Number of (root, target) pairs */
+};
+
+/*
+** Free a bfsvtab_msbfs object.
+*/
+static void bfsvtabMsbfsFree(bfsvtab_msbfs *p) {
+    if (p) {
+        sqlite3_free(p->aSeen);
+        sqlite3_free(p->aPrev);
+        sqlite3_free(p->aCur);
+        bfsvtabKeysClear(&p->prev);
+        bfsvtabKeysClear(&p->level);
+        sqlite3_free(p);
+    }
+}
+
+/*
+** Allocate a bfsvtab_msbfs for traversals of pCsr over nKey keys from the
+** nRoot distinct nodes in aRoot[], at most BFSVTAB_MSBFS_WIDTH of them.
+** The root aRoot[i] is given bit i.
+*/
+static int bfsvtabMsbfsNew(
+    sqlite3_int64 nKey,
+    const sqlite3_int64 *aRoot,
+    sqlite3_int64 nRoot,
+    bfsvtab_msbfs **ppOut
+) {
+    bfsvtab_msbfs *p;
+    sqlite3_int64 i;
+    int rc;
+
+    assert(nRoot <= BFSVTAB_MSBFS_WIDTH);
+    *ppOut = 0;
+    p = sqlite3_malloc(sizeof(*p));
+    if (p == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(p, 0, sizeof(*p));
+    p->nKey = nKey;
+    p->aSeen = sqlite3_malloc64(nKey * sizeof(sqlite3_uint64));
+    p->aPrev = sqlite3_malloc64(nKey * sizeof(sqlite3_uint64));
+    p->aCur = sqlite3_malloc64(nKey * sizeof(sqlite3_uint64));
+    if (p->aSeen == 0 || p->aPrev == 0 || p->aCur == 0) {
+        bfsvtabMsbfsFree(p);
+        return SQLITE_NOMEM;
+    }
+    memset(p->aSeen, 0, nKey * sizeof(sqlite3_uint64));
+    memset(p->aPrev, 0, nKey * sizeof(sqlite3_uint64));
+    memset(p->aCur, 0, nKey * sizeof(sqlite3_uint64));
+    for (i = 0; i < nRoot; i++) {
+        p->aSeen[aRoot[i]] = p->aCur[aRoot[i]] = ((sqlite3_uint64)1) << i;
+        rc = bfsvtabKeysAppend(&p->level, aRoot[i]);
+        if (rc != SQLITE_OK) {
+            bfsvtabMsbfsFree(p);
+            return rc;
+        }
+    }
+    *ppOut = p;
+    return SQLITE_OK;
+}
+
+/*
+** Replace the level with the nodes one step further from each root.  The
+** words of the level before it are cleared and reused for the new level.
+*/
+static int bfsvtabMsbfsStep(bfsvtab_msbfs *p, bfsvtab_csr *pCsr) {
+    sqlite3_uint64 *aNext = p->aPrev;
+    bfsvtab_keys next = p->prev;
+    sqlite3_int64 i, j;
+    int rc = SQLITE_OK;
+
+    for (i = 0; i < next.n; i++) {
+        aNext[next.a[i]] = 0;
+    }
+    next.n = 0;
+    for (i = 0; rc == SQLITE_OK && i < p->level.n; i++) {
+        sqlite3_int64 iKey = p->level.a[i];
+        sqlite3_uint64 m = p->aCur[iKey];
+        if (iKey >= pCsr->nNode) {
+            continue;
+        }
+        for (j = pCsr->aOffset[iKey]; j < pCsr->aOffset[iKey + 1]; j++) {
+            unsigned int iTo = pCsr->aTarget[j];
+            sqlite3_uint64 mNew = m & ~p->aSeen[iTo];
+            if (mNew == 0) {
+                continue;
+            }
+            if (aNext[iTo] == 0) {
+                rc = bfsvtabKeysAppend(&next, iTo);
+                if (rc != SQLITE_OK) {
+                    break;
+                }
+            }
+            aNext[iTo] |= mNew;
+        }
+    }
+    /* Only now, so that every edge into a node counts for this level */
+    for (i = 0; i < next.n; i++) {
+        p->aSeen[next.a[i]] |= aNext[next.a[i]];
+    }
+
+    p->aPrev = p->aCur;
+    p->aCur = aNext;
+    p->prev = p->level;
+    p->level = next;
+    p->iPos = 0;
+    p->mLeft = 0;
+    p->iDistance++;
+    return rc;
+}
+
+/*
+** Return the parent of node iKey on a shortest path from the root of bit
+** iBit: its first predecessor in the reverse adjacency that is one step
+** closer to that root.
+*/
+static sqlite3_int64 bfsvtabMsbfsParent(
+    bfsvtab_msbfs *p,
+    bfsvtab_csr *pCsr,
+    sqlite3_int64 iKey,
+    int iBit
+) {
+    sqlite3_int64 j;
+    if (p->iDistance == 0 || iKey >= pCsr->nNode) {
+        return iKey;
+    }
+    for (j = pCsr->aRevOffset[iKey]; j < pCsr->aRevOffset[iKey + 1]; j++) {
+        unsigned int iFrom = pCsr->aRevSource[j];
+        if ((p->aPrev[iFrom] >> iBit) & 1) {
+            return iFrom;
+        }
+    }
+    return iKey;
+}
+
+/*
+** End of the multi-source traversal
+******************************************************************************/
+
+/******************************************************************************
+** Weighted traversal
+**
+** With a weight column, nodes are returned in order of the total weight
+** of the lightest path from the root, as found by Dijkstra's algorithm.
+** Nodes that have been reached are kept in aNode[], through a hash from
+** node key to index.  The candidates for the next node are kept in a
+** 4-ary min-heap ordered by path weight.  A node whose weight drops is
+** pushed again rather than moved, and the stale entry is skipped when
+** it reaches the top.
+**
+** For A* search each node also carries an estimate of the weight left to
+** the target, computed once when the node is first reached, and the heap
+** is ordered by path weight plus estimate instead.
+*/
+#define BFSVTAB_HEAP_ARITY 4
+
+typedef struct bfsvtab_dijkstra_node bfsvtab_dijkstra_node;
+typedef struct bfsvtab_heap_entry bfsvtab_heap_entry;
+
+struct bfsvtab_dijkstra_node {
+    double rCost;               /* Weight of the lightest path found so far */
+    sqlite3_int64 iParent;      /* Key of the previous node on that path */
+    sqlite3_int64 nHop;         /* Number of edges on that path */
+    double rEstimate;           /* Estimated weight from here to the target */
+    int bDone;                  /* True once the node has been returned */
+};
+
+struct bfsvtab_heap_entry {
+    double rCost;               /* Path weight plus estimate when pushed */
+    sqlite3_int64 iKey;         /* Key of the node */
+};
+
+struct bfsvtab_dijkstra {
+    bfsvtab_hash index;         /* Map from node key to index in aNode[] */
+    bfsvtab_dijkstra_node *aNode;   /* Nodes reached so far */
+    sqlite3_int64 nNode;        /* Number of entries in aNode[] */
+    sqlite3_int64 nNodeAlloc;   /* Allocated size of aNode[] */
+    bfsvtab_heap_entry *aHeap;  /* Min-heap of candidate nodes */
+    sqlite3_int64 nHeap;        /* Number of entries in aHeap[] */
+    sqlite3_int64 nHeapAlloc;   /* Allocated size of aHeap[] */
+};
+
+/*
+** Remove every node and candidate, but keep the memory for reuse.
+*/
+static void bfsvtabDijkstraReset(bfsvtab_dijkstra *p) {
+    bfsvtabHashReset(&p->index);
+    p->nNode = 0;
+    p->nHeap = 0;
+}
+
+/*
+** Free a bfsvtab_dijkstra object.
+*/
+static void bfsvtabDijkstraFree(bfsvtab_dijkstra *p) {
+    if (p) {
+        bfsvtabHashClear(&p->index);
+        sqlite3_free(p->aNode);
+        sqlite3_free(p->aHeap);
+        sqlite3_free(p);
+    }
+}
+
+/*
+** Return the entry for node iKey, or NULL if it has not been reached.
+*/
+static bfsvtab_dijkstra_node *bfsvtabDijkstraFind(
+    bfsvtab_dijkstra *p,
+    sqlite3_int64 iKey
+) {
+    bfsvtab_hash_entry *pEntry = bfsvtabHashSearch(&p->index, iKey);
+    return pEntry ? &p->aNode[pEntry->value] : 0;
+}
+
+/*
+** Add a candidate to the heap.
+*/
+static int bfsvtabHeapPush(bfsvtab_dijkstra *p, double rCost, sqlite3_int64 iKey) {
+    sqlite3_int64 i;
+    if (p->nHeap >= p->nHeapAlloc) {
+        sqlite3_int64 nNew = p->nHeapAlloc ? p->nHeapAlloc * 2 : 256;
+        bfsvtab_heap_entry *aNew = sqlite3_realloc64(p->aHeap,
+                nNew * sizeof(bfsvtab_heap_entry));
+        if (aNew == 0) {
+            return SQLITE_NOMEM;
+        }
+        p->aHeap = aNew;
+        p->nHeapAlloc = nNew;
+    }
+    /* Sift up */
+    for (i = p->nHeap++; i > 0; ) {
+        sqlite3_int64 iUp = (i - 1) / BFSVTAB_HEAP_ARITY;
+        if (p->aHeap[iUp].rCost <= rCost) {
+            break;
+        }
+        p->aHeap[i] = p->aHeap[iUp];
+        i = iUp;
+    }
+    p->aHeap[i].rCost = rCost;
+    p->aHeap[i].iKey = iKey;
+    return SQLITE_OK;
+}
+
+/*
+** Remove the candidate with the lowest weight from the heap, which must
+** not be empty, and return it.
+*/
+static bfsvtab_heap_entry bfsvtabHeapPop(bfsvtab_dijkstra *p) {
+    bfsvtab_heap_entry top = p->aHeap[0];
+    bfsvtab_heap_entry last = p->aHeap[--p->nHeap];
+    sqlite3_int64 i = 0;
+    /* Sift down */
+    for (;;) {
+        sqlite3_int64 iChild = i * BFSVTAB_HEAP_ARITY + 1;
+        sqlite3_int64 iEnd = iChild + BFSVTAB_HEAP_ARITY;
+        sqlite3_int64 iMin = -1;
+        sqlite3_int64 j;
+        if (iEnd > p->nHeap) {
+            iEnd = p->nHeap;
+        }
+        for (j = iChild; j < iEnd; j++) {
+            if (iMin < 0 || p->aHeap[j].rCost < p->aHeap[iMin].rCost) {
+                iMin = j;
+            }
+        }
+        if (iMin < 0 || p->aHeap[iMin].rCost >= last.rCost) {
+            break;
+        }
+        p->aHeap[i] = p->aHeap[iMin];
+        i = iMin;
+    }
+    if (p->nHeap > 0) {
+        p->aHeap[i] = last;
+    }
+    return top;
+}
+
+/*
+** Record a path of weight rCost and nHop edges to node iKey through node
+** iParent, unless a path at least as light is already known or the node
+** has already been returned.  rEstimate is only used if the node has not
+** been reached before.
+*/
+static int bfsvtabDijkstraRelax(
+    bfsvtab_dijkstra *p,
+    sqlite3_int64 iKey,
+    sqlite3_int64 iParent,
+    double rCost,
+    sqlite3_int64 nHop,
+    double rEstimate
+) {
+    bfsvtab_dijkstra_node *pNode;
+    int bNew;
+    int rc = bfsvtabHashInsert(&p->index, iKey, p->nNode, &bNew);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    if (bNew) {
+        if (p->nNode >= p->nNodeAlloc) {
+            sqlite3_int64 nNew = p->nNodeAlloc ? p->nNodeAlloc * 2 : 256;
+            bfsvtab_dijkstra_node *aNew = sqlite3_realloc64(p->aNode,
+                    nNew * sizeof(bfsvtab_dijkstra_node));
+            if (aNew == 0) {
+                return SQLITE_NOMEM;
+            }
+            p->aNode = aNew;
+            p->nNodeAlloc = nNew;
+        }
+        pNode = &p->aNode[p->nNode++];
+        pNode->rEstimate = rEstimate;
+        pNode->bDone = 0;
+    } else {
+        pNode = bfsvtabDijkstraFind(p, iKey);
+        if (pNode->bDone || pNode->rCost <= rCost) {
+            return SQLITE_OK;
+        }
+    }
+    pNode->rCost = rCost;
+    pNode->iParent = iParent;
+    pNode->nHop = nHop;
+    return bfsvtabHeapPush(p, rCost + pNode->rEstimate, iKey);
+}
+
+/*
+** Remove the lightest node that has not been returned from the heap, mark
+** it as returned and set *piKey to its key.  Return 0 if there is none.
+*/
+static int bfsvtabDijkstraPop(bfsvtab_dijkstra *p, sqlite3_int64 *piKey) {
+    while (p->nHeap > 0) {
+        bfsvtab_heap_entry top = bfsvtabHeapPop(p);
+        bfsvtab_dijkstra_node *pNode = bfsvtabDijkstraFind(p, top.iKey);
+        if (pNode->bDone || top.rCost > pNode->rCost + pNode->rEstimate) {
+            continue;
+        }
+        pNode->bDone = 1;
+        *piKey = top.iKey;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+** End of the weighted traversal
+******************************************************************************/
+
+/*
+** This function converts an SQL quoted string into an unquoted string
+** and returns a pointer to a buffer allocated using sqlite3_malloc() 
+** containing the result. The caller should eventually free this buffer
+** using sqlite3_free.
+**
+** Examples:
+**
+**     "abc"   becomes   abc
+**     'xyz'   becomes   xyz
+**     [pqr]   becomes   pqr
+**     `mno`   becomes   mno
+*/
+static char *bfsvtabDequote(const char *zIn) {
+    sqlite3_int64 nIn;              /* Size of input string, in bytes */
+    char *zOut;                     /* Output (dequoted) string */
+
+    nIn = strlen(zIn);
+    zOut = sqlite3_malloc64(nIn + 1);
+    if (zOut) {
+        char q = zIn[0];              /* Quote character (if any ) */
+
+        if (q != '[' && q != '\'' && q != '"' && q != '`') {
+            memcpy(zOut, zIn, (size_t)(nIn + 1));
+        } else {
+            int iOut = 0;               /* Index of next byte to write to output */
+            int iIn;                    /* Index of next byte to read from input */
+
+            if (q == '[') {
+                q = ']';
+            }
+            for (iIn = 1; iIn < nIn; iIn++) {
+                if (zIn[iIn] == q) {
+                    iIn++;
+                }
+                zOut[iOut++] = zIn[iIn];
+            }
+        }
+        assert((int)strlen(zOut) <= nIn);
+    }
+    return zOut;
+}
+
+/*
+** Check to see if the argument is of the form:
+**
+**       KEY = VALUE
+**
+** If it is, return a pointer to the first character of VALUE.
+** If not, return NULL.  Spaces around the = are ignored.
+*/
+static const char *bfsvtabValueOfKey(const char *zKey, const char *zStr){
+    int nKey = (int)strlen(zKey);
+    int nStr = (int)strlen(zStr);
+    int i;
+    if (nStr < nKey + 1) {
+        return 0;
+    }
+    if (memcmp(zStr, zKey, nKey) != 0) {
+        return 0;
+    }
+    for (i = nKey; isspace((unsigned char)zStr[i]); i++) {
+        ;
+    }
+    if (zStr[i] != '=') {
+        return 0;
+    }
+    i++;
+    while (isspace((unsigned char)zStr[i])) { 
+        i++; 
+    }
+    return zStr + i;
+}
+
+/*
+** An in-memory adjacency kept by a bfsvtab_vtab so that later queries
+** against the same edge relation can reuse it.  The entry is valid only
+** as long as the database has not changed since it was built.
+*/
+struct bfsvtab_cache {
+    char *zTableName;           /* Key: name of the edge table */
+    char *zFromColumn;          /* Key: name of the from column */
+    char *zToColumn;            /* Key: name of the to column */
+    char *zWeightColumn;        /* Key: name of the weight column, or "" */
+    int bBoth;                  /* Key: true if edges are loaded both ways */
+    int bMapped;                /* True if pCsr is the one in the mapped file */
+    int bShared;                /* True if pCsr was offered to other connections */
+    char *zLog;                 /* Temp table logging edge changes, or NULL */
+    sqlite3_int64 iForeign;     /* PRAGMA data_version when zLog was emptied */
+    sqlite3_uint64 iSchema;     /* Schema versions when zLog was emptied */
+    int bRowid;                 /* True if zLog logs rows removed by REPLACE */
+    sqlite3_stmt *pProbe;       /* Statement that reads from zTableName */
+    sqlite3_uint64 iVersion;    /* Data versions of all databases when built */
+    int nChange;                /* sqlite3_total_changes() when built */
+    bfsvtab_csr *pCsr;          /* The cached adjacency */
+    bfsvtab_cache *pNext;       /* Next entry, in most recently used order */
+};
+
+/* Maximum number of bfsvtab_cache entries kept by each bfsvtab_vtab */
+#define BFSVTAB_MAX_CACHE 4
+
+/*
+** Free a bfsvtab_cache entry, dropping its reference to the adjacency.
+*/
+static void bfsvtabCacheFree(bfsvtab_cache *p) {
+    sqlite3_free(p->zTableName);
+    sqlite3_free(p->zFromColumn);
+    sqlite3_free(p->zToColumn);
+    sqlite3_free(p->zWeightColumn);
+    sqlite3_free(p->zLog);
+    sqlite3_finalize(p->pProbe);
+    bfsvtabCsrUnref(p->pCsr);
+    sqlite3_free(p);
+}
+
+/* bfsvtab_vtab is a subclass of sqlite3_vtab which is
+** underlying representation of the virtual table
+*/
+typedef struct bfsvtab_vtab bfsvtab_vtab;
+struct bfsvtab_vtab {
+    sqlite3_vtab base;  /* Base class - must be first */
+    /* Add new fields here, as necessary */
+    char *zDb;
+    char *zSelf;
+    int bShadow;        /* True unless this is the eponymous table */
+    char *zTableName;
+    char *zFromColumn;
+    char *zToColumn;
+    char *zWeightColumn;    /* Default weight column, or NULL */
+    char *zHeuristic;       /* Default heuristic function, or NULL */
+    int nBatch;         /* Default number of nodes expanded per statement */
+    int eAdjacency;     /* Default BFSVTAB_ADJACENCY_* value */
+    int eEngine;        /* Default BFSVTAB_ENGINE_* value */
+    int nThread;        /* Default number of threads per traversal */
+    int eVisited;       /* Default BFSVTAB_VISITED_* value */
+    int eSources;       /* Default BFSVTAB_SOURCES_* value */
+    int eDirection;     /* Default BFSVTAB_DIRECTION_* value */
+    int eRefresh;       /* Default BFSVTAB_REFRESH_* value */
+    sqlite3_int64 nMemLimit;    /* Default memlimit, or 0 for none */
+    bfsvtab_cache *pCache;  /* Cached adjacencies, most recently used first */
+    bfsvtab_stmt *pStmtCache;   /* Idle statements, most recently used first */
+    bfsvtab_shared *pShared;    /* Cache shared with other connections */
+    char *zCountTable;      /* Edge table counted in nCount, or NULL */
+    sqlite3_int64 nCount;   /* Number of rows in zCountTable */
+    sqlite3_uint64 iCountVersion;   /* Data versions when it was counted */
+    int nCountChange;       /* Total change count when it was counted */
+    sqlite3 *db;
+};
+
+/*
+** A prepared statement that is not in use by any cursor, kept so that the
+** next xFilter that needs the same SQL does not have to prepare it again.
+** This matters when xFilter runs once per row of an outer loop, as in
+**
+**     SELECT ... FROM roots JOIN bfsvtab ON bfsvtab.root = roots.id
+**
+** The SQL text names the edge table and columns, so it serves as the key.
+** Statements prepared with sqlite3_prepare_v2() are re-prepared by SQLite
+** itself when the schema changes, so a cached statement never goes stale.
+*/
+struct bfsvtab_stmt {
+    sqlite3_stmt *pStmt;        /* The statement, reset with no bindings */
+    bfsvtab_stmt *pNext;        /* Next idle statement */
+};
+
+/* Maximum number of idle statements kept by each bfsvtab_vtab */
+#define BFSVTAB_MAX_STMT 16
+
+/*
+** Set *ppStmt to a prepared statement for zSql, taking it from the idle
+** statements of pVtab if there is one.  The caller owns the statement
+** until it passes it to bfsvtabStmtRelease().
+*/
+static int bfsvtabStmtAcquire(
+    bfsvtab_vtab *pVtab,
+    const char *zSql,
+    sqlite3_stmt **ppStmt
+) {
+    bfsvtab_stmt **pp;
+    for (pp = &pVtab->pStmtCache; *pp; pp = &(*pp)->pNext) {
+        if (strcmp(sqlite3_sql((*pp)->pStmt), zSql) == 0) {
+            bfsvtab_stmt *p = *pp;
+            *pp = p->pNext;
+            *ppStmt = p->pStmt;
+            sqlite3_free(p);
+            return SQLITE_OK;
+        }
+    }
+    return sqlite3_prepare_v2(pVtab->db, zSql, -1, ppStmt, 0);
+}
+
+/*
+** Return statement pStmt, obtained from bfsvtabStmtAcquire(), to the idle
+** statements of pVtab.  If there are too many, the least recently used
+** one is finalized.
+*/
+static void bfsvtabStmtRelease(bfsvtab_vtab *pVtab, sqlite3_stmt *pStmt) {
+    bfsvtab_stmt *p;
+    int n;
+
+    if (pStmt == 0) {
+        return;
+    }
+    sqlite3_reset(pStmt);
+    sqlite3_clear_bindings(pStmt);
+    p = sqlite3_malloc(sizeof(*p));
+    if (p == 0) {
+        sqlite3_finalize(pStmt);
+        return;
+    }
+    p->pStmt = pStmt;
+    p->pNext = pVtab->pStmtCache;
+    pVtab->pStmtCache = p;
+    for (n = 1; p->pNext; p = p->pNext, n++) {
+        if (n == BFSVTAB_MAX_STMT) {
+            sqlite3_finalize(p->pNext->pStmt);
+            sqlite3_free(p->pNext);
+            p->pNext = 0;
+            break;
+        }
+    }
+}
+
+/* bfsvtab_cursor is a subclass of sqlite3_vtab_cursor which will
+** serve as the underlying representation of a cursor that scans
+** over rows of the result
+*/
+typedef struct bfsvtab_cursor bfsvtab_cursor;
+struct bfsvtab_cursor {
+    sqlite3_vtab_cursor base;  /* Base class - must be first */
+    /* Insert new fields here.  For this bfsvtab we only keep track
+    ** of the rowid */
+    sqlite3_int64 iRowid;      /* The rowid */
+    sqlite3_stmt *pStmt;       /* Prepared statement to return node neighbours */
+
+    bfsvtab_vtab *pVtab;       /* The virtual table this cursor belongs to */
+    char *zTableName;          /* Name of table holding edge relation */
+    char *zFromColumn;         /* Name of from column of zTableName */
+    char *zToColumn;           /* Name of to column of zTableName */
+    char *zWeightColumn;       /* Name of weight column of zTableName */
+    char *zHeuristic;          /* Name of the A* heuristic function */
+
+#ifdef BFSVTAB_USE_AVL
+    bfsvtab_avl *pVisited;     /* Set of Visited Nodes */
+    bfsvtab_slab avlSlab;      /* Allocator for the entries of pVisited */
+#else
+    bfsvtab_hash visited;      /* Set of Visited Nodes, mapping id to parent */
+#endif
+    int eVisited;              /* BFSVTAB_VISITED_* value requested */
+    sqlite3_int64 iDenseMin;   /* Smallest key covered by aDenseBit[] */
+    sqlite3_int64 nDense;      /* Number of keys covered by aDenseBit[] */
+    sqlite3_uint64 *aDenseBit; /* Visited bit of each key, or NULL */
+    sqlite3_int64 *aDenseParent;  /* Parent of each key whose bit is set, or NULL */
+    int bParent;               /* True if parents are needed for output */
+
+    bfsvtab_queue pQueue;      /* Queue of next Nodes */
+    bfsvtab_node current;      /* The current row */
+    bfsvtab_node *pCurrent;    /* &current, or NULL at EOF */
+    sqlite3_int64 root;        /* Id of the first root of the traversal */
+    bfsvtab_keys roots;        /* Ids of all roots, without duplicates */
+    sqlite3_int64 iRoot;       /* Index in roots of the next root to start */
+    int eSources;              /* BFSVTAB_SOURCES_* value requested */
+    int eDirection;            /* BFSVTAB_DIRECTION_* value requested */
+    int eRefresh;              /* BFSVTAB_REFRESH_* value requested */
+    sqlite3_int64 iMinDepth;   /* Do not return nodes closer than this */
+    sqlite3_int64 iMaxDepth;   /* Do not expand nodes at this distance */
+
+    int nBatch;                /* Number of nodes expanded per statement */
+    int nPending;              /* Queued nodes already expanded by a batch */
+    bfsvtab_batch batch;       /* Batched expansion state */
+
+    int eAdjacency;            /* BFSVTAB_ADJACENCY_* value requested */
+    bfsvtab_csr *pCsr;         /* In-memory adjacency, or NULL for lookups */
+
+    int bTargets;              /* True to return only nodes in targets */
+    bfsvtab_hash targets;      /* Keys of the nodes to return */
+    sqlite3_int64 nTarget;     /* Number of entries in targets */
+    sqlite3_int64 nTargetSeen; /* Number of targets visited so far */
+    sqlite3_int64 nTargetLeft; /* Number of targets not yet returned */
+    sqlite3_int64 iTarget;     /* Key of the most recently added target */
+
+    sqlite3_stmt *pRevStmt;    /* Statement to return nodes with an edge to a node */
+    sqlite3_stmt *pHeuristic;  /* SELECT h(?1, target), for an A* search */
+    int bOnPath;               /* True to visit only nodes in onPath */
+    bfsvtab_hash onPath;       /* Nodes on a shortest path to the target */
+
+    int eEngine;               /* BFSVTAB_ENGINE_* value requested */
+    bfsvtab_diropt *pDiropt;   /* Level-at-a-time traversal state, or NULL */
+    bfsvtab_msbfs *pMsbfs;     /* Multi-source traversal state, or NULL */
+    bfsvtab_dijkstra *pDijkstra;  /* Weighted traversal state, or NULL */
+    double rMaxCost;           /* Do not return paths heavier than this */
+    int nThread;               /* Number of threads for the diropt engine */
+    sqlite3_int64 nMemLimit;   /* Bytes the traversal may hold, or 0 */
+
+    bfsvtab_paths aPath[2];    /* Paths of nodes at distance d in aPath[d&1] */
+};
+
+/*
+** Ways of finding the neighbours of a node.  With LOOKUP, the edge table
+** is queried once per node (or per batch of nodes).  With CSR, the whole
+** edge table is loaded into a bfsvtab_csr when the traversal starts.
+** AUTO uses LOOKUP, which only reads the part of the graph that is
+** reached, unless the engine needs the whole graph in memory.  STORED is CSR with
+** the bfsvtab_csr kept in shadow tables between connections, MAPPED is
+** CSR with the bfsvtab_csr kept in a file that connections map, and
+** SHARED is CSR with the bfsvtab_csr shared by the connections of the
+** process.
+*/
+#define BFSVTAB_ADJACENCY_AUTO    0
+#define BFSVTAB_ADJACENCY_LOOKUP  1
+#define BFSVTAB_ADJACENCY_CSR     2
+#define BFSVTAB_ADJACENCY_STORED  3
+#define BFSVTAB_ADJACENCY_MAPPED  4
+#define BFSVTAB_ADJACENCY_SHARED  5
+
+static const char *const azBfsvtabAdjacency[] = {
+    "auto", "lookup", "csr", "stored", "mapped", "shared"
+};
+
+/*
+** Return the BFSVTAB_ADJACENCY_* value named by zName, or -1 if zName is
+** not a recognized adjacency mode.
+*/
+static int bfsvtabAdjacencyMode(const char *zName) {
+    int i;
+    for (i = 0; zName && i < (int)(sizeof(azBfsvtabAdjacency)/sizeof(char*)); i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabAdjacency[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+** Traversal engines.  TOPDOWN expands one node at a time from a queue.
+** DIROPT finds a whole level at a time over the in-memory adjacency,
+** switching between top-down and bottom-up steps (see bfsvtab_diropt).
+** MSBFS searches from up to 64 roots of a root IN (...) at once over the
+** in-memory adjacency (see bfsvtab_msbfs).
+*/
+#define BFSVTAB_ENGINE_TOPDOWN    0
+#define BFSVTAB_ENGINE_DIROPT     1
+#define BFSVTAB_ENGINE_MSBFS      2
+
+static const char *const azBfsvtabEngine[] = { "topdown", "diropt", "msbfs" };
+
+/*
+** Return the BFSVTAB_ENGINE_* value named by zName, or -1 if zName is
+** not a recognized engine.
+*/
+static int bfsvtabEngineMode(const char *zName) {
+    int i;
+    for (i = 0; zName && i < (int)(sizeof(azBfsvtabEngine)/sizeof(char*)); i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabEngine[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+** Representations of the set of visited nodes.  SPARSE is the hash table
+** (or AVL tree).  DENSE is a bitmap with one bit per key in a range, and
+** a parent array indexed the same way, with SPARSE still used for any key
+** outside the range.  AUTO uses DENSE with the in-memory adjacency, whose
+** keys are dense by construction, and SPARSE otherwise.  Forcing DENSE
+** when neighbours are looked up in the edge table makes the range that
+** of the values in the to column, found with min() and max().
+*/
+#define BFSVTAB_VISITED_AUTO      0
+#define BFSVTAB_VISITED_SPARSE    1
+#define BFSVTAB_VISITED_DENSE     2
+
+static const char *const azBfsvtabVisited[] = { "auto", "sparse", "dense" };
+
+/* Largest number of keys covered by a dense visited set */
+#define BFSVTAB_MAX_DENSE (((sqlite3_int64)1) << 32)
+
+/* Most keys a dense visited set covers for each node the graph can have */
+#define BFSVTAB_DENSE_SPREAD 16
+
+/*
+** Return the BFSVTAB_VISITED_* value named by zName, or -1 if zName is
+** not a recognized mode.
+*/
+static int bfsvtabVisitedMode(const char *zName) {
+    int i;
+    for (i = 0; zName && i < (int)(sizeof(azBfsvtabVisited)/sizeof(char*)); i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabVisited[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+** How a root IN (...) constraint is answered.  With EACH, there is one
+** traversal per root, just as if root = ? had been used with each value
+** in turn.  With NEAREST, a single traversal starts from all of the roots
+** at once, so that each node is returned once, at its distance from the
+** nearest root.  The root column of a row then holds the root it was
+** reached from.
+*/
+#define BFSVTAB_SOURCES_EACH      0
+#define BFSVTAB_SOURCES_NEAREST   1
+
+static const char *const azBfsvtabSources[] = { "each", "nearest" };
+
+/*
+** Return the BFSVTAB_SOURCES_* value named by zName, or -1 if zName is
+** not a recognized mode.
+*/
+static int bfsvtabSourcesMode(const char *zName) {
+    int i;
+    for (i = 0; zName && i < (int)(sizeof(azBfsvtabSources)/sizeof(char*)); i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabSources[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+** Which edges are followed out of a node.  FORWARD follows edges from the
+** from column to the to column, REVERSE follows them the other way, and
+** BOTH follows them either way, treating the graph as undirected.
+*/
+#define BFSVTAB_DIRECTION_FORWARD 0
+#define BFSVTAB_DIRECTION_REVERSE 1
+#define BFSVTAB_DIRECTION_BOTH    2
+
+static const char *const azBfsvtabDirection[] = { "forward", "reverse", "both" };
+
+/*
+** Return the BFSVTAB_DIRECTION_* value named by zName, or -1 if zName is
+** not a recognized mode.
+*/
+static int bfsvtabDirectionMode(const char *zName) {
+    int i;
+    for (i = 0; zName && i < (int)(sizeof(azBfsvtabDirection)/sizeof(char*)); i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabDirection[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+** How a cached in-memory adjacency catches up with changes to the edge
+** table made by this connection.  REBUILD loads it again from scratch.
+** INCREMENTAL logs the changes with temp triggers and applies just those
+** (see bfsvtabLogApply()).
+*/
+#define BFSVTAB_REFRESH_REBUILD     0
+#define BFSVTAB_REFRESH_INCREMENTAL 1
+
+static const char *const azBfsvtabRefresh[] = { "rebuild", "incremental" };
+
+/*
+** Return the BFSVTAB_REFRESH_* value named by zName, or -1 if zName is
+** not a recognized mode.
+*/
+static int bfsvtabRefreshMode(const char *zName) {
+    int i;
+    for (i = 0; zName && i < (int)(sizeof(azBfsvtabRefresh)/sizeof(char*)); i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabRefresh[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+** Return the node id for node key iKey.  Nodes are identified by their id
+** when neighbours are looked up in the edge table, and by their index in
+** the snapshot when an in-memory adjacency is used.  A root node that
+** does not appear in the edge table at all is given the key nNode.
+*/
+static sqlite3_int64 bfsvtabNodeId(bfsvtab_cursor *pCur, sqlite3_int64 iKey) {
+    if (pCur->pCsr == 0) {
+        return iKey;
+    }
+    if (iKey < pCur->pCsr->nNode) {
+        return pCur->pCsr->aId[iKey];
+    }
+    return pCur->roots.a[iKey - pCur->pCsr->nNode];
+}
+
+/*
+** Return true if the node with key iKey is to be returned as a row.
+** That is every node, unless the query constrains the id column.
+*/
+static int bfsvtabIsTarget(bfsvtab_cursor *pCur, sqlite3_int64 iKey) {
+    return pCur->bTargets == 0
+        || bfsvtabHashSearch(&pCur->targets, iKey) != 0;
+}
+
+/*
+** Look up node id in the set of visited nodes.  If it is present, write
+** the id of its parent into *pParent (if not NULL) and return 1.
+** Otherwise return 0.
+*/
+static int bfsvtabVisitedFind(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 id,
+    sqlite3_int64 *pParent
+) {
+#ifdef BFSVTAB_USE_AVL
+    bfsvtab_avl *p;
+#else
+    bfsvtab_hash_entry *p;
+#endif
+    sqlite3_uint64 iDense = (sqlite3_uint64)id - (sqlite3_uint64)pCur->iDenseMin;
+    if (pCur->pDijkstra) {
+        bfsvtab_dijkstra_node *pNode = bfsvtabDijkstraFind(pCur->pDijkstra, id);
+        if (pNode == 0) {
+            return 0;
+        }
+        if (pParent) {
+            *pParent = pNode->iParent;
+        }
+        return 1;
+    }
+    if (pCur->pDiropt) {
+        /* A level-at-a-time traversal keeps its own parent array */
+        if (!bfsvtabDiroptSeen(pCur->pDiropt, id)) {
+            return 0;
+        }
+        if (pParent && pCur->pDiropt->aParent) {
+            *pParent = pCur->pDiropt->aParent[id];
+        }
+        return 1;
+    }
+    if (iDense < (sqlite3_uint64)pCur->nDense) {
+        if ((pCur->aDenseBit[iDense / 64] & (((sqlite3_uint64)1) << (iDense % 64))) == 0) {
+            return 0;
+        }
+        if (pParent && pCur->aDenseParent) {
+            *pParent = pCur->aDenseParent[iDense];
+        }
+        return 1;
+    }
+#ifdef BFSVTAB_USE_AVL
+    p = bfsvtabAvlSearch(pCur->pVisited, id);
+#else
+    p = bfsvtabHashSearch(&pCur->visited, id);
+#endif
+    if (p == 0) {
+        return 0;
+    }
+    if (pParent) {
+#ifdef BFSVTAB_USE_AVL
+        *pParent = p->parent;
+#else
+        *pParent = p->value;
+#endif
+    }
+    return 1;
+}
+
+/*
+** Add node id, reached from node parent, to the set of visited nodes.
+** If it was already there, leave it unchanged and set *pbNew to 0.
+** Otherwise set *pbNew to 1.
+*/
+static int bfsvtabVisitedAdd(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 id,
+    sqlite3_int64 parent,
+    int *pbNew
+) {
+    sqlite3_uint64 iDense = (sqlite3_uint64)id - (sqlite3_uint64)pCur->iDenseMin;
+#ifdef BFSVTAB_USE_AVL
+    bfsvtab_avl *pNew;
+#endif
+    if (iDense < (sqlite3_uint64)pCur->nDense) {
+        sqlite3_uint64 *pWord = &pCur->aDenseBit[iDense / 64];
+        sqlite3_uint64 mask = ((sqlite3_uint64)1) << (iDense % 64);
+        *pbNew = (*pWord & mask) == 0;
+        if (*pbNew) {
+            *pWord |= mask;
+            if (pCur->aDenseParent) {
+                pCur->aDenseParent[iDense] = parent;
+            }
+        }
+        return SQLITE_OK;
+    }
+#ifdef BFSVTAB_USE_AVL
+    *pbNew = 0;
+    if (bfsvtabAvlSearch(pCur->pVisited, id) != 0) {
+        return SQLITE_OK;
+    }
+    pNew = bfsvtabSlabAlloc(&pCur->avlSlab);
+    if (pNew == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(pNew, 0, sizeof(*pNew));
+    pNew->id = id;
+    pNew->parent = parent;
+    bfsvtabAvlInsert(&pCur->pVisited, pNew);
+    *pbNew = 1;
+    return SQLITE_OK;
+#else
+    return bfsvtabHashInsert(&pCur->visited, id, parent, pbNew);
+#endif
+}
+
+/*
+** Make the set of visited nodes, which must be empty, use a bitmap and a
+** parent array for the nDense keys starting at iMin.  The parent array is
+** left uninitialized, as an entry is only read once its bit is set, and is
+** omitted entirely when no parents are needed for output.  If the arrays
+** cannot be allocated, the hash table is used as before.
+*/
+static void bfsvtabVisitedDense(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 iMin,
+    sqlite3_int64 nDense
+) {
+    sqlite3_int64 nWord = (nDense + 63) / 64;
+    pCur->aDenseBit = sqlite3_malloc64(nWord * sizeof(sqlite3_uint64));
+    if (pCur->bParent) {
+        pCur->aDenseParent = sqlite3_malloc64(nDense * sizeof(sqlite3_int64));
+    }
+    if (pCur->aDenseBit == 0 || (pCur->bParent && pCur->aDenseParent == 0)) {
+        sqlite3_free(pCur->aDenseBit);
+        sqlite3_free(pCur->aDenseParent);
+        pCur->aDenseBit = 0;
+        pCur->aDenseParent = 0;
+        return;
+    }
+    memset(pCur->aDenseBit, 0, nWord * sizeof(sqlite3_uint64));
+    pCur->iDenseMin = iMin;
+    pCur->nDense = nDense;
+}
+
+/*
+** Remove all nodes from the set of visited nodes.
+*/
+static void bfsvtabVisitedClear(bfsvtab_cursor *pCur) {
+    sqlite3_free(pCur->aDenseBit);
+    sqlite3_free(pCur->aDenseParent);
+    pCur->aDenseBit = 0;
+    pCur->aDenseParent = 0;
+    pCur->iDenseMin = 0;
+    pCur->nDense = 0;
+#ifdef BFSVTAB_USE_AVL
+    bfsvtabSlabClear(&pCur->avlSlab);
+    pCur->pVisited = 0;
+#else
+    bfsvtabHashClear(&pCur->visited);
+#endif
+}
+
+/*
+** Remove all nodes from the set of visited nodes, but keep its memory for
+** the traversal from the next root.
+*/
+static void bfsvtabVisitedReset(bfsvtab_cursor *pCur) {
+    if (pCur->aDenseBit) {
+        memset(pCur->aDenseBit, 0, ((pCur->nDense + 63) / 64) * sizeof(sqlite3_uint64));
+    }
+#ifdef BFSVTAB_USE_AVL
+    bfsvtabSlabClear(&pCur->avlSlab);
+    pCur->pVisited = 0;
+#else
+    bfsvtabHashReset(&pCur->visited);
+#endif
+}
+
+/*
+** Return the value of the root column for the current row.  When the
+** traversal started from several roots at once, that is the root at the
+** end of the row's path back through its parents.
+*/
+static sqlite3_int64 bfsvtabRowRoot(bfsvtab_cursor *pCur) {
+    sqlite3_int64 iKey = pCur->pCurrent->id;
+    sqlite3_int64 iParent = pCur->pCurrent->parent;
+    if (pCur->pMsbfs) {
+        return pCur->roots.a[pCur->pMsbfs->iBase + pCur->pMsbfs->iBit];
+    }
+    if (pCur->eSources != BFSVTAB_SOURCES_NEAREST || pCur->roots.n < 2) {
+        return pCur->root;
+    }
+    while (iParent != iKey) {
+        iKey = iParent;
+        if (bfsvtabVisitedFind(pCur, iKey, &iParent) == 0) {
+            break;
+        }
+    }
+    return bfsvtabNodeId(pCur, iKey);
+}
+
+/*
+** Deallocate a bfsvtab_vtab object
+*/
+static void bfsvtabFree(bfsvtab_vtab *p) {
+    if (p) {
+        while (p->pCache) {
+            bfsvtab_cache *pNext = p->pCache->pNext;
+            bfsvtabCacheFree(p->pCache);
+            p->pCache = pNext;
+        }
+        while (p->pStmtCache) {
+            bfsvtab_stmt *pNext = p->pStmtCache->pNext;
+            sqlite3_finalize(p->pStmtCache->pStmt);
+            sqlite3_free(p->pStmtCache);
+            p->pStmtCache = pNext;
+        }
+        sqlite3_free(p->zDb);
+        sqlite3_free(p->zSelf);
+        sqlite3_free(p->zTableName);
+        sqlite3_free(p->zFromColumn);
+        sqlite3_free(p->zToColumn);
+        sqlite3_free(p->zWeightColumn);
+        sqlite3_free(p->zHeuristic);
+        sqlite3_free(p->zCountTable);
+        memset(p, 0, sizeof(*p));
+        sqlite3_free(p);
+    }
+}
+
+/*
+** Return the name of the file of the main database of db, and set
+** aCounter[] to its file change counter.  Return NULL if the database has
+** no file, or if the counter is not kept up to date: in WAL mode, and in
+** exclusive locking mode, where it is only incremented by the first
+** commit while the lock is held.  The counter is read from the file, so
+** a read transaction must be open for it to be current: the shared lock
+** it holds keeps other connections from committing until it ends, so the
+** header read then is the one the pager of db sees.  The mapped and
+** shared adjacencies depend on this stamp, and so are not used in WAL
+** mode or in exclusive locking mode.
+*/
+static const char *bfsvtabFileCounter(sqlite3 *db, unsigned char *aCounter) {
+    const char *zFile = sqlite3_db_filename(db, "main");
+    sqlite3_file *pFile = 0;
+    sqlite3_stmt *pStmt = 0;
+    unsigned char aHdr[100];
+    int bNormal = 0;
+
+    if (sqlite3_prepare_v2(db, "PRAGMA main.locking_mode", -1, &pStmt, 0)
+            == SQLITE_OK
+        && sqlite3_step(pStmt) == SQLITE_ROW) {
+        const char *zMode = (const char*)sqlite3_column_text(pStmt, 0);
+        bNormal = zMode && sqlite3_stricmp(zMode, "normal") == 0;
+    }
+    sqlite3_finalize(pStmt);
+    if (bNormal == 0 || zFile == 0 || zFile[0] == 0
+        || sqlite3_file_control(db, "main", SQLITE_FCNTL_FILE_POINTER,
+                                &pFile) != SQLITE_OK
+        || pFile == 0 || pFile->pMethods == 0
+        || pFile->pMethods->xRead(pFile, aHdr, sizeof(aHdr), 0) != SQLITE_OK
+        || aHdr[18] == 2) {
+        /* No file, or a read and write version of 2, which is WAL mode */
+        return 0;
+    }
+    memcpy(aCounter, &aHdr[24], 4);
+    return zFile;
+}
+
+/*
+** Set *pbMain to true if the edge table zTable is a table of the main
+** database that no temp table or view of the same name hides, which is
+** the only case in which the file change counter of the main database
+** tells whether it has changed.
+*/
+static int bfsvtabIsMainTable(sqlite3 *db, const char *zTable, int *pbMain) {
+    sqlite3_stmt *pStmt = 0;
+    int rc;
+
+    *pbMain = 0;
+    rc = sqlite3_prepare_v2(db,
+        "SELECT EXISTS (SELECT 1 FROM main.sqlite_master"
+        " WHERE type = 'table' AND name = ?1 COLLATE NOCASE)"
+        " AND NOT EXISTS (SELECT 1 FROM temp.sqlite_master"
+        " WHERE name = ?1 COLLATE NOCASE)", -1, &pStmt, 0);
+    if (rc == SQLITE_OK) {
+        sqlite3_bind_text(pStmt, 1, zTable, -1, SQLITE_STATIC);
+        if (sqlite3_step(pStmt) == SQLITE_ROW) {
+            *pbMain = sqlite3_column_int(pStmt, 0);
+        }
+        rc = sqlite3_finalize(pStmt);
+    }
+    return rc;
+}
+
+/******************************************************************************
+** Stored adjacency
+**
+** A table created with CREATE VIRTUAL TABLE can keep a copy of an
+** in-memory adjacency in three shadow tables, so that a later connection
+** can load it instead of scanning and sorting the edge table.  The copy
+** is only written by the rebuild command (see bfsvtabUpdate()), never by
+** a query, and xCreate must be the same as xConnect for the module to be
+** usable as an eponymous table, so the tables are created by the first
+** rebuild:
+**
+**     x_config(k TEXT PRIMARY KEY, v) WITHOUT ROWID
+**     x_offsets(block INTEGER PRIMARY KEY, ids BLOB, offsets BLOB)
+**     x_targets(block INTEGER PRIMARY KEY, targets BLOB, weights BLOB)
+**     x_stamp(v)
+**
+** The config table names the edge relation that the copy was made from,
+** and holds the numbers of nodes and edges.  The next two hold aId[] and
+** aOffset[], and aTarget[] and aWeight[], in blocks of BFSVTAB_STORED_BLOCK
+** entries each, as arrays in native byte order.  The "byteorder" entry is
+** the 64-bit integer 1 in that order, so that a copy written on a machine
+** of the other byte order is rebuilt rather than misread.
+**
+** The stamp table holds one row while the copy is up to date.  The rebuild
+** also creates the triggers x_stamp_insert, x_stamp_delete and
+** x_stamp_update on the edge table, which empty it on any change to the
+** edge relation, from whichever connection.  A copy is only used while
+** its stamp row and all three triggers exist, so dropping the edge table,
+** which drops its triggers, also retires the copy.  As the stamp is read
+** and cleared through SQL it is transactional and works in any journal
+** mode.  It is not a shadow table, because defensive mode would not let
+** the triggers write to one.
+**
+** Only one edge relation is stored per table, the last one rebuilt, and
+** the edge table must be in the same database as the virtual table, the
+** main one.  SQLite takes the part of a table name after its last "_" as
+** the shadow table suffix, so the suffixes have none.
+*/
+#define BFSVTAB_STORED_BLOCK  65536
+#define BFSVTAB_STORED_FORMAT "3"
+
+/*
+** The suffixes of the tables that hold a stored adjacency.  All but the
+** last, the stamp table, are shadow tables.
+*/
+static const char *const azBfsvtabShadow[] = {
+    "config", "offsets", "targets", "stamp"
+};
+#define BFSVTAB_NSHADOW 3
+#define BFSVTAB_NSTORED 4
+
+/*
+** The kinds of change to the edge table that a trigger clears the stamp
+** of the stored adjacency on.
+*/
+static const char *const azBfsvtabStampEvent[] = {
+    "insert", "delete", "update"
+};
+
+/*
+** The config entries that must match for a stored copy to be used.
+*/
+#define BFSVTAB_STORED_NKEY 6
+static const char *const azBfsvtabStoredKey[BFSVTAB_STORED_NKEY] = {
+    "format", "tablename", "fromcolumn", "tocolumn", "weightcolumn",
+    "direction"
+};
+
+/*
+** Set azVal[] to the values of the config entries in azBfsvtabStoredKey[]
+** for the given edge relation.
+*/
+static void bfsvtabStoredConfig(
+    const char **azVal,
+    const char *zTable,
+    const char *zFrom,
+    const char *zTo,
+    const char *zWeight,
+    int bBoth
+) {
+    azVal[0] = BFSVTAB_STORED_FORMAT;
+    azVal[1] = zTable;
+    azVal[2] = zFrom;
+    azVal[3] = zTo;
+    azVal[4] = zWeight ? zWeight : "";
+    azVal[5] = azBfsvtabDirection[bBoth ? BFSVTAB_DIRECTION_BOTH
+                                        : BFSVTAB_DIRECTION_FORWARD];
+}
+
+/*
+** Set *pbCurrent to true if the shadow tables of pVtab hold an up to date
+** copy of an adjacency of edge table zTable: its stamp row and the three
+** triggers that clear it are all still there.
+*/
+static int bfsvtabStoredCurrent(
+    bfsvtab_vtab *pVtab,
+    const char *zTable,
+    int *pbCurrent
+) {
+    sqlite3_stmt *pStmt = 0;
+    char *zSql;
+    int rc;
+
+    *pbCurrent = 0;
+    if (sqlite3_stricmp(pVtab->zDb, "main") != 0) {
+        return SQLITE_OK;
+    }
+    rc = bfsvtabIsMainTable(pVtab->db, zTable, pbCurrent);
+    if (rc != SQLITE_OK || *pbCurrent == 0) {
+        return rc;
+    }
+    *pbCurrent = 0;
+    zSql = sqlite3_mprintf(
+        "SELECT (SELECT count(*) FROM main.\"%w_stamp\") = 1"
+        " AND (SELECT count(*) FROM main.sqlite_master WHERE type = 'trigger'"
+        " AND tbl_name = ?1 COLLATE NOCASE"
+        " AND name IN ('%q_stamp_%s', '%q_stamp_%s', '%q_stamp_%s')) = 3",
+        pVtab->zSelf, pVtab->zSelf, azBfsvtabStampEvent[0],
+        pVtab->zSelf, azBfsvtabStampEvent[1],
+        pVtab->zSelf, azBfsvtabStampEvent[2]);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = sqlite3_prepare_v2(pVtab->db, zSql, -1, &pStmt, 0);
+    sqlite3_free(zSql);
+    if (rc != SQLITE_OK) {
+        /* Nothing has been stored yet */
+        return rc == SQLITE_NOMEM ? rc : SQLITE_OK;
+    }
+    sqlite3_bind_text(pStmt, 1, zTable, -1, SQLITE_STATIC);
+    if (sqlite3_step(pStmt) == SQLITE_ROW) {
+        *pbCurrent = sqlite3_column_int(pStmt, 0);
+    }
+    return sqlite3_finalize(pStmt);
+}
+
+/*
+** Run the SQL statement made from zFormat and the following arguments
+** as if by sqlite3_mprintf().
+*/
+static int bfsvtabExecf(sqlite3 *db, const char *zFormat, ...) {
+    va_list ap;
+    char *zSql;
+    int rc;
+    va_start(ap, zFormat);
+    zSql = sqlite3_vmprintf(zFormat, ap);
+    va_end(ap);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = sqlite3_exec(db, zSql, 0, 0, 0);
+    sqlite3_free(zSql);
+    return rc;
+}
+
+/*
+** Prepare the statement made from zFormat and the following arguments.
+*/
+static int bfsvtabPreparef(
+    sqlite3 *db,
+    sqlite3_stmt **ppStmt,
+    const char *zFormat,
+    ...
+) {
+    va_list ap;
+    char *zSql;
+    int rc;
+    va_start(ap, zFormat);
+    zSql = sqlite3_vmprintf(zFormat, ap);
+    va_end(ap);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = sqlite3_prepare_v2(db, zSql, -1, ppStmt, 0);
+    sqlite3_free(zSql);
+    return rc;
+}
+
+/*
+** Load the stored adjacency of pVtab into a new bfsvtab_csr, if it was
+** made from the given edge relation and is up to date.  Otherwise, or if
+** the shadow tables do not hold a consistent copy, set *ppCsr to NULL.
+*/
+static int bfsvtabStoredLoad(
+    bfsvtab_vtab *pVtab,
+    const char *zTable,
+    const char *zFrom,
+    const char *zTo,
+    const char *zWeight,
+    int bBoth,
+    bfsvtab_csr **ppCsr
+) {
+    const char *azVal[BFSVTAB_STORED_NKEY];
+    sqlite3_stmt *pStmt = 0;
+    bfsvtab_csr *p = 0;
+    sqlite3_int64 nNode = -1;
+    sqlite3_int64 nEdge = -1;
+    sqlite3_int64 iOne = 1;
+    sqlite3_int64 n, i;
+    int nMatch = 0;
+    int nByte;
+    int bNew;
+    int bCurrent;
+    int rc;
+
+    *ppCsr = 0;
+    rc = bfsvtabStoredCurrent(pVtab, zTable, &bCurrent);
+    if (rc != SQLITE_OK || bCurrent == 0) {
+        return rc;
+    }
+    bfsvtabStoredConfig(azVal, zTable, zFrom, zTo, zWeight, bBoth);
+    rc = bfsvtabPreparef(pVtab->db, &pStmt,
+        "SELECT k, v FROM \"%w\".\"%w_config\"", pVtab->zDb, pVtab->zSelf);
+    if (rc != SQLITE_OK) {
+        return rc == SQLITE_NOMEM ? rc : SQLITE_OK;
+    }
+    while (sqlite3_step(pStmt) == SQLITE_ROW) {
+        const char *zKey = (const char*)sqlite3_column_text(pStmt, 0);
+        if (zKey == 0) {
+            continue;
+        }
+        if (strcmp(zKey, "nodes") == 0) {
+            nNode = sqlite3_column_int64(pStmt, 1);
+        } else if (strcmp(zKey, "edges") == 0) {
+            nEdge = sqlite3_column_int64(pStmt, 1);
+        } else if (strcmp(zKey, "byteorder") == 0) {
+            nMatch += sqlite3_column_bytes(pStmt, 1) == (int)sizeof(iOne)
+                && memcmp(sqlite3_column_blob(pStmt, 1), &iOne, sizeof(iOne)) == 0;
+        } else {
+            const char *zVal = (const char*)sqlite3_column_text(pStmt, 1);
+            for (i = 0; i < BFSVTAB_STORED_NKEY; i++) {
+                if (strcmp(zKey, azBfsvtabStoredKey[i]) == 0) {
+                    nMatch += zVal && strcmp(zVal, azVal[i]) == 0;
+                }
+            }
+        }
+    }
+    rc = sqlite3_finalize(pStmt);
+    pStmt = 0;
+    if (rc != SQLITE_OK || nMatch != BFSVTAB_STORED_NKEY + 1
+        || nNode < 0 || nNode > 0xffffffff || nEdge < 0) {
+        return rc;
+    }
+
+    p = sqlite3_malloc(sizeof(*p));
+    if (p == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(p, 0, sizeof(*p));
+    p->nRef = 1;
+    p->nNode = nNode;
+    p->nEdge = nEdge;
+    p->aId = sqlite3_malloc64((nNode ? nNode : 1) * sizeof(sqlite3_int64));
+    p->aOffset = sqlite3_malloc64((nNode + 1) * sizeof(sqlite3_int64));
+    p->aTarget = sqlite3_malloc64((nEdge ? nEdge : 1) * sizeof(unsigned int));
+    if (zWeight) {
+        p->aWeight = sqlite3_malloc64((nEdge ? nEdge : 1) * sizeof(double));
+    }
+    if (p->aId == 0 || p->aOffset == 0 || p->aTarget == 0
+        || (zWeight && p->aWeight == 0)) {
+        rc = SQLITE_NOMEM;
+        goto storedLoadError;
+    }
+
+    rc = bfsvtabPreparef(pVtab->db, &pStmt,
+        "SELECT ids, offsets FROM \"%w\".\"%w_offsets\" ORDER BY block",
+        pVtab->zDb, pVtab->zSelf);
+    if (rc != SQLITE_OK) {
+        goto storedLoadError;
+    }
+    n = 0;
+    while (sqlite3_step(pStmt) == SQLITE_ROW) {
+        nByte = sqlite3_column_bytes(pStmt, 0);
+        if (nByte % sizeof(sqlite3_int64) != 0
+            || sqlite3_column_bytes(pStmt, 1) != nByte
+            || n + nByte / (int)sizeof(sqlite3_int64) > nNode) {
+            goto storedLoadCorrupt;
+        }
+        if (nByte > 0) {
+            memcpy(&p->aId[n], sqlite3_column_blob(pStmt, 0), nByte);
+            memcpy(&p->aOffset[n], sqlite3_column_blob(pStmt, 1), nByte);
+        }
+        n += nByte / sizeof(sqlite3_int64);
+    }
+    rc = sqlite3_finalize(pStmt);
+    pStmt = 0;
+    if (rc != SQLITE_OK) {
+        goto storedLoadError;
+    }
+    if (n != nNode) {
+        goto storedLoadCorrupt;
+    }
+    p->aOffset[nNode] = nEdge;
+
+    rc = bfsvtabPreparef(pVtab->db, &pStmt,
+        "SELECT targets, weights FROM \"%w\".\"%w_targets\" ORDER BY block",
+        pVtab->zDb, pVtab->zSelf);
+    if (rc != SQLITE_OK) {
+        goto storedLoadError;
+    }
+    n = 0;
+    while (sqlite3_step(pStmt) == SQLITE_ROW) {
+        sqlite3_int64 nEntry;
+        nByte = sqlite3_column_bytes(pStmt, 0);
+        nEntry = nByte / sizeof(unsigned int);
+        if (nByte % sizeof(unsigned int) != 0 || n + nEntry > nEdge
+            || (zWeight && sqlite3_column_bytes(pStmt, 1)
+                           != nEntry * (sqlite3_int64)sizeof(double))) {
+            goto storedLoadCorrupt;
+        }
+        if (nByte > 0) {
+            memcpy(&p->aTarget[n], sqlite3_column_blob(pStmt, 0), nByte);
+            if (zWeight) {
+                memcpy(&p->aWeight[n], sqlite3_column_blob(pStmt, 1),
+                       nEntry * sizeof(double));
+            }
+        }
+        n += nEntry;
+    }
+    rc = sqlite3_finalize(pStmt);
+    pStmt = 0;
+    if (rc != SQLITE_OK) {
+        goto storedLoadError;
+    }
+    if (n != nEdge) {
+        goto storedLoadCorrupt;
+    }
+
+    /* Check everything the traversals rely on before trusting the copy */
+    for (i = 0; i < nNode; i++) {
+        if (p->aOffset[i] < 0 || p->aOffset[i] > p->aOffset[i + 1]) {
+            goto storedLoadCorrupt;
+        }
+        rc = bfsvtabHashInsert(&p->index, p->aId[i], i, &bNew);
+        if (rc != SQLITE_OK) {
+            goto storedLoadError;
+        }
+        if (bNew == 0) {
+            goto storedLoadCorrupt;
+        }
+    }
+    for (i = 0; i < nEdge; i++) {
+        if (p->aTarget[i] >= nNode) {
+            goto storedLoadCorrupt;
+        }
+    }
+    *ppCsr = p;
+    return SQLITE_OK;
+
+storedLoadCorrupt:
+    rc = SQLITE_OK;
+storedLoadError:
+    sqlite3_finalize(pStmt);
+    bfsvtabCsrUnref(p);
+    return rc;
+}
+
+/*
+** Replace the stored adjacency of pVtab with pCsr, which was made from
+** the given edge relation, and stamp it as up to date.  This runs inside
+** the write transaction of the rebuild command.  The stamp is cleared
+** first and set last, so a copy left half written by an error is never
+** used.
+*/
+static int bfsvtabStoredSave(
+    bfsvtab_vtab *pVtab,
+    const char *zTable,
+    const char *zFrom,
+    const char *zTo,
+    const char *zWeight,
+    int bBoth,
+    bfsvtab_csr *pCsr
+) {
+    const char *azVal[BFSVTAB_STORED_NKEY];
+    sqlite3 *db = pVtab->db;
+    sqlite3_stmt *pStmt = 0;
+    sqlite3_int64 iOne = 1;
+    sqlite3_int64 i, n;
+    int rc;
+
+    bfsvtabStoredConfig(azVal, zTable, zFrom, zTo, zWeight, bBoth);
+    rc = bfsvtabExecf(db,
+        "CREATE TABLE IF NOT EXISTS \"%w\".\"%w_config\"("
+            "k TEXT PRIMARY KEY, v) WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS \"%w\".\"%w_offsets\"("
+            "block INTEGER PRIMARY KEY, ids BLOB, offsets BLOB);"
+        "CREATE TABLE IF NOT EXISTS \"%w\".\"%w_targets\"("
+            "block INTEGER PRIMARY KEY, targets BLOB, weights BLOB);"
+        "CREATE TABLE IF NOT EXISTS \"%w\".\"%w_stamp\"(v);",
+        pVtab->zDb, pVtab->zSelf, pVtab->zDb, pVtab->zSelf,
+        pVtab->zDb, pVtab->zSelf, pVtab->zDb, pVtab->zSelf);
+    for (i = BFSVTAB_NSTORED - 1; rc == SQLITE_OK && i >= 0; i--) {
+        rc = bfsvtabExecf(db, "DELETE FROM \"%w\".\"%w_%s\"",
+                          pVtab->zDb, pVtab->zSelf, azBfsvtabShadow[i]);
+    }
+    for (i = 0; rc == SQLITE_OK && i < 3; i++) {
+        rc = bfsvtabExecf(db, "DROP TRIGGER IF EXISTS \"%w\".\"%w_stamp_%s\"",
+                          pVtab->zDb, pVtab->zSelf, azBfsvtabStampEvent[i]);
+    }
+
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabPreparef(db, &pStmt,
+            "INSERT INTO \"%w\".\"%w_config\"(k, v) VALUES(?1, ?2)",
+            pVtab->zDb, pVtab->zSelf);
+    }
+    for (i = 0; rc == SQLITE_OK && i < BFSVTAB_STORED_NKEY + 3; i++) {
+        if (i < BFSVTAB_STORED_NKEY) {
+            sqlite3_bind_text(pStmt, 1, azBfsvtabStoredKey[i], -1, SQLITE_STATIC);
+            sqlite3_bind_text(pStmt, 2, azVal[i], -1, SQLITE_STATIC);
+        } else if (i == BFSVTAB_STORED_NKEY) {
+            sqlite3_bind_text(pStmt, 1, "byteorder", -1, SQLITE_STATIC);
+            sqlite3_bind_blob(pStmt, 2, &iOne, sizeof(iOne), SQLITE_STATIC);
+        } else {
+            int bNodes = i == BFSVTAB_STORED_NKEY + 1;
+            sqlite3_bind_text(pStmt, 1, bNodes ? "nodes" : "edges", -1, SQLITE_STATIC);
+            sqlite3_bind_int64(pStmt, 2, bNodes ? pCsr->nNode : pCsr->nEdge);
+        }
+        sqlite3_step(pStmt);
+        rc = sqlite3_reset(pStmt);
+    }
+    sqlite3_finalize(pStmt);
+    pStmt = 0;
+
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabPreparef(db, &pStmt,
+            "INSERT INTO \"%w\".\"%w_offsets\"(block, ids, offsets)"
+            " VALUES(?1, ?2, ?3)",
+            pVtab->zDb, pVtab->zSelf);
+    }
+    for (i = 0; rc == SQLITE_OK && i < pCsr->nNode; i += n) {
+        n = pCsr->nNode - i;
+        if (n > BFSVTAB_STORED_BLOCK) n = BFSVTAB_STORED_BLOCK;
+        sqlite3_bind_int64(pStmt, 1, i / BFSVTAB_STORED_BLOCK);
+        sqlite3_bind_blob64(pStmt, 2, &pCsr->aId[i],
+                            n * sizeof(sqlite3_int64), SQLITE_STATIC);
+        sqlite3_bind_blob64(pStmt, 3, &pCsr->aOffset[i],
+                            n * sizeof(sqlite3_int64), SQLITE_STATIC);
+        sqlite3_step(pStmt);
+        rc = sqlite3_reset(pStmt);
+    }
+    sqlite3_finalize(pStmt);
+    pStmt = 0;
+
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabPreparef(db, &pStmt,
+            "INSERT INTO \"%w\".\"%w_targets\"(block, targets, weights)"
+            " VALUES(?1, ?2, ?3)",
+            pVtab->zDb, pVtab->zSelf);
+    }
+    for (i = 0; rc == SQLITE_OK && i < pCsr->nEdge; i += n) {
+        n = pCsr->nEdge - i;
+        if (n > BFSVTAB_STORED_BLOCK) n = BFSVTAB_STORED_BLOCK;
+        sqlite3_bind_int64(pStmt, 1, i / BFSVTAB_STORED_BLOCK);
+        sqlite3_bind_blob64(pStmt, 2, &pCsr->aTarget[i],
+                            n * sizeof(unsigned int), SQLITE_STATIC);
+        if (pCsr->aWeight) {
+            sqlite3_bind_blob64(pStmt, 3, &pCsr->aWeight[i],
+                                n * sizeof(double), SQLITE_STATIC);
+        }
+        sqlite3_step(pStmt);
+        rc = sqlite3_reset(pStmt);
+    }
+    sqlite3_finalize(pStmt);
+
+    /* Any change to the columns of the relation clears the stamp */
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabExecf(db,
+            "CREATE TRIGGER \"%w\".\"%w_stamp_insert\" AFTER INSERT ON \"%w\""
+            " BEGIN DELETE FROM \"%w_stamp\"; END;"
+            "CREATE TRIGGER \"%w\".\"%w_stamp_delete\" AFTER DELETE ON \"%w\""
+            " BEGIN DELETE FROM \"%w_stamp\"; END;"
+            "CREATE TRIGGER \"%w\".\"%w_stamp_update\""
+            " AFTER UPDATE OF \"%w\", \"%w\"%s%w%s ON \"%w\""
+            " BEGIN DELETE FROM \"%w_stamp\"; END;"
+            "INSERT INTO \"%w\".\"%w_stamp\"(v) VALUES(1);",
+            pVtab->zDb, pVtab->zSelf, zTable, pVtab->zSelf,
+            pVtab->zDb, pVtab->zSelf, zTable, pVtab->zSelf,
+            pVtab->zDb, pVtab->zSelf, zFrom, zTo,
+            zWeight ? ", \"" : "", zWeight ? zWeight : "", zWeight ? "\"" : "",
+            zTable, pVtab->zSelf, pVtab->zDb, pVtab->zSelf);
+    }
+    return rc;
+}
+
+/*
+** End of the stored adjacency
+******************************************************************************/
+
+/*
+** Return the 64-bit FNV-1a hash of string z, used to give the files and
+** tables made for an edge relation short names.
+*/
+static sqlite3_uint64 bfsvtabHashString(const char *z) {
+    sqlite3_uint64 h = (((sqlite3_uint64)0xcbf29ce4)<<32) | 0x84222325;
+    while (*z) {
+        h = (h ^ (unsigned char)*z++) * ((((sqlite3_uint64)0x100)<<32) | 0x1b3);
+    }
+    return h;
+}
+
+/******************************************************************************
+** Mapped adjacency
+**
+** With adjacency = 'mapped', the in-memory adjacency is also written to a
+** file next to the database, named after the database file and a hash of
+** the edge relation:
+**
+**     <database>-bfsvtab-<16 hex digits>
+**
+** Later connections, in this process or another, map the file with mmap()
+** and traverse it in place, so that they share one copy in the page cache
+** instead of each building its own.  The file holds a bfsvtab_map_header,
+** the edge relation it was made from, and then aId[], aOffset[], aTarget[],
+** aWeight[] if there are weights, and the slots of the id index, each
+** padded to a multiple of 8 bytes, in native byte order.
+**
+** The header records the file change counter of the database, which each
+** commit increments in rollback journal mode, and a file whose counter is
+** not the database's is out of date.  The counter is not kept up to date
+** in WAL mode or in exclusive locking mode, so there, as for in-memory and
+** temporary databases, no file is used and the adjacency is kept in
+** memory only.  So it is when the edge table is not a table of the main
+** database, or a temp table or view of the same name hides it, as the
+** counter does not change with those.
+**
+** A new file is written under a temporary name and renamed into place, so
+** that the connections that mapped the old one keep a consistent copy.
+*/
+#define BFSVTAB_MAP_MAGIC "bfsvtab map 1\n"
+
+struct bfsvtab_map_header {
+    char zMagic[16];            /* BFSVTAB_MAP_MAGIC, zero padded */
+    unsigned int iByteOrder;    /* 1, in the byte order of the writer */
+    unsigned char aCounter[4];  /* File change counter of the database */
+    unsigned int nKey;          /* Bytes in the relation that follows */
+    unsigned int bWeight;       /* True if aWeight[] is present */
+    sqlite3_int64 nNode;        /* Number of nodes */
+    sqlite3_int64 nEdge;        /* Number of edges */
+    sqlite3_int64 nSlot;        /* Number of slots in the id index */
+    sqlite3_int64 nEntry;       /* Number of used slots */
+    sqlite3_int64 bEmpty;       /* The sEmpty entry of the id index */
+    sqlite3_int64 iEmptyValue;
+};
+
+/* Round n up to a multiple of 8 */
+#define BFSVTAB_PAD8(n) (((n) + 7) & ~(sqlite3_int64)7)
+
+/*
+** Return a description of the edge relation of cache entry p, as kept in
+** the header of its file or in the key of its shared cache entry, or NULL
+** if out of memory.
+*/
+static char *bfsvtabRelationKey(bfsvtab_cache *p) {
+    return sqlite3_mprintf("%s\n%s\n%s\n%s\n%d\n", p->zTableName,
+            p->zFromColumn, p->zToColumn, p->zWeightColumn, p->bBoth);
+}
+
+#if BFSVTAB_MMAP
+/*
+** Set *pzPath to the name of the file for the edge relation zKey of cache
+** entry p, and aCounter[] to the file change counter of the main database.
+** *pzPath is set to NULL if the relation cannot have such a file.  The
+** caller must free it.
+*/
+static int bfsvtabMapPath(
+    bfsvtab_vtab *pVtab,
+    bfsvtab_cache *p,
+    const char *zKey,
+    char **pzPath,
+    unsigned char *aCounter
+) {
+    const char *zFile = bfsvtabFileCounter(pVtab->db, aCounter);
+    int bMain = 0;
+    int rc;
+
+    *pzPath = 0;
+    if (zFile == 0) {
+        return SQLITE_OK;
+    }
+    rc = bfsvtabIsMainTable(pVtab->db, p->zTableName, &bMain);
+    if (rc != SQLITE_OK || bMain == 0) {
+        return rc;
+    }
+    *pzPath = sqlite3_mprintf("%s-bfsvtab-%016llx", zFile, bfsvtabHashString(zKey));
+    return *pzPath ? SQLITE_OK : SQLITE_NOMEM;
+}
+
+/*
+** Set up p to use the nMap bytes at pMap, which were read from a file
+** made for the relation zKey when the database's file change counter was
+** aCounter[].  Return false if the file is not for that relation, is out
+** of date, or does not hold a consistent adjacency.  Every array is read
+** once, as a damaged file must not lead a traversal out of bounds.
+*/
+static int bfsvtabMapCheck(
+    bfsvtab_csr *p,
+    unsigned char *pMap,
+    sqlite3_int64 nMap,
+    const char *zKey,
+    const unsigned char *aCounter,
+    int bWeight
+) {
+    bfsvtab_map_header hdr;
+    char zMagic[16];
+    sqlite3_int64 nKey = (sqlite3_int64)strlen(zKey);
+    sqlite3_int64 iOff, nUsed, i;
+
+    if (nMap < (sqlite3_int64)sizeof(hdr)) {
+        return 0;
+    }
+    memcpy(&hdr, pMap, sizeof(hdr));
+    memset(zMagic, 0, sizeof(zMagic));
+    memcpy(zMagic, BFSVTAB_MAP_MAGIC, sizeof(BFSVTAB_MAP_MAGIC) - 1);
+    if (memcmp(hdr.zMagic, zMagic, sizeof(zMagic)) != 0
+        || hdr.iByteOrder != 1
+        || memcmp(hdr.aCounter, aCounter, 4) != 0
+        || hdr.nKey != nKey
+        || (hdr.bWeight != 0) != (bWeight != 0)
+        || hdr.nNode < 0 || hdr.nNode > 0xffffffff
+        || hdr.nEdge < 0 || hdr.nEdge > nMap / 4
+        || hdr.nSlot < 0 || hdr.nSlot > nMap / 16
+        || (hdr.nSlot & (hdr.nSlot - 1)) != 0
+        || hdr.nEntry < 0 || hdr.nEntry * 2 > hdr.nSlot
+        || BFSVTAB_PAD8(nKey) + (sqlite3_int64)sizeof(hdr)
+           + (2 * hdr.nNode + 1) * (sqlite3_int64)sizeof(sqlite3_int64)
+           + BFSVTAB_PAD8(hdr.nEdge * (sqlite3_int64)sizeof(unsigned int))
+           + (bWeight ? hdr.nEdge * (sqlite3_int64)sizeof(double) : 0)
+           + hdr.nSlot * (sqlite3_int64)sizeof(bfsvtab_hash_entry) != nMap
+        || memcmp(pMap + sizeof(hdr), zKey, nKey) != 0) {
+        return 0;
+    }
+
+    iOff = sizeof(hdr) + BFSVTAB_PAD8(nKey);
+    p->nNode = hdr.nNode;
+    p->nEdge = hdr.nEdge;
+    p->aId = (sqlite3_int64*)&pMap[iOff];
+    iOff += hdr.nNode * sizeof(sqlite3_int64);
+    p->aOffset = (sqlite3_int64*)&pMap[iOff];
+    iOff += (hdr.nNode + 1) * sizeof(sqlite3_int64);
+    p->aTarget = (unsigned int*)&pMap[iOff];
+    iOff += BFSVTAB_PAD8(hdr.nEdge * (sqlite3_int64)sizeof(unsigned int));
+    if (bWeight) {
+        p->aWeight = (double*)&pMap[iOff];
+        iOff += hdr.nEdge * sizeof(double);
+    }
+    p->index.aSlot = hdr.nSlot ? (bfsvtab_hash_entry*)&pMap[iOff] : 0;
+    p->index.nSlot = hdr.nSlot;
+    p->index.nEntry = hdr.nEntry;
+    p->index.bEmpty = hdr.bEmpty != 0;
+    p->index.sEmpty.id = BFSVTAB_HASH_EMPTY;
+    p->index.sEmpty.value = hdr.iEmptyValue;
+
+    if (p->aOffset[0] != 0 || p->aOffset[p->nNode] != p->nEdge
+        || (p->index.bEmpty && (hdr.iEmptyValue < 0 || hdr.iEmptyValue >= p->nNode))) {
+        return 0;
+    }
+    for (i = 0; i < p->nNode; i++) {
+        if (p->aOffset[i] > p->aOffset[i + 1]) {
+            return 0;
+        }
+    }
+    for (i = 0; i < p->nEdge; i++) {
+        if (p->aTarget[i] >= p->nNode) {
+            return 0;
+        }
+    }
+    /* Searches end at an empty slot, so there must be one */
+    for (nUsed = 0, i = 0; i < p->index.nSlot; i++) {
+        if (p->index.aSlot[i].id != BFSVTAB_HASH_EMPTY) {
+            if (p->index.aSlot[i].value < 0 || p->index.aSlot[i].value >= p->nNode) {
+                return 0;
+            }
+            nUsed++;
+        }
+    }
+    if (nUsed != p->index.nEntry) {
+        return 0;
+    }
+    for (i = 0; i < p->nNode; i++) {
+        bfsvtab_hash_entry *pEntry = bfsvtabHashSearch(&p->index, p->aId[i]);
+        if (pEntry == 0 || pEntry->value != i) {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif /* BFSVTAB_MMAP */
+
+/*
+** Map the file of the edge relation of cache entry p into a new
+** bfsvtab_csr, if there is one for the current content of the database.
+** Otherwise set *ppCsr to NULL.
+*/
+static int bfsvtabMapLoad(
+    bfsvtab_vtab *pVtab,
+    bfsvtab_cache *p,
+    bfsvtab_csr **ppCsr
+) {
+#if BFSVTAB_MMAP
+    bfsvtab_csr *pCsr;
+    unsigned char aCounter[4];
+    char *zKey;
+    char *zPath = 0;
+    void *pMap = MAP_FAILED;
+    struct stat st;
+    int fd;
+    int rc;
+
+    *ppCsr = 0;
+    zKey = bfsvtabRelationKey(p);
+    if (zKey == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = bfsvtabMapPath(pVtab, p, zKey, &zPath, aCounter);
+    if (rc != SQLITE_OK || zPath == 0) {
+        sqlite3_free(zKey);
+        return rc;
+    }
+    fd = open(zPath, O_RDONLY);
+    sqlite3_free(zPath);
+    if (fd >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(bfsvtab_map_header)) {
+            pMap = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if (pMap == MAP_FAILED) {
+        sqlite3_free(zKey);
+        return SQLITE_OK;
+    }
+    pCsr = sqlite3_malloc(sizeof(*pCsr));
+    if (pCsr == 0) {
+        munmap(pMap, (size_t)st.st_size);
+        sqlite3_free(zKey);
+        return SQLITE_NOMEM;
+    }
+    memset(pCsr, 0, sizeof(*pCsr));
+    pCsr->nRef = 1;
+    pCsr->pMap = pMap;
+    pCsr->nMap = st.st_size;
+    if (bfsvtabMapCheck(pCsr, pMap, st.st_size, zKey, aCounter,
+                        p->zWeightColumn[0] != 0)) {
+        *ppCsr = pCsr;
+    } else {
+        bfsvtabCsrUnref(pCsr);
+    }
+    sqlite3_free(zKey);
+    return SQLITE_OK;
+#else
+    (void)pVtab;
+    (void)p;
+    *ppCsr = 0;
+    return SQLITE_OK;
+#endif
+}
+
+/*
+** Write the adjacency of cache entry p to the file of its edge relation.
+** A failure to write it, for example because the directory is read-only,
+** is not an error, and leaves any older file as it was.
+*/
+static int bfsvtabMapSave(bfsvtab_vtab *pVtab, bfsvtab_cache *p) {
+#if BFSVTAB_MMAP
+    static const unsigned char aZero[8] = { 0 };
+    bfsvtab_csr *pCsr = p->pCsr;
+    bfsvtab_map_header hdr;
+    unsigned char aCounter[4];
+    sqlite3_uint64 iRandom;
+    char *zKey;
+    char *zPath = 0;
+    char *zTmp;
+    FILE *pOut;
+    sqlite3_int64 nKey;
+    int bOk;
+    int rc;
+
+    zKey = bfsvtabRelationKey(p);
+    if (zKey == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = bfsvtabMapPath(pVtab, p, zKey, &zPath, aCounter);
+    if (rc != SQLITE_OK || zPath == 0) {
+        sqlite3_free(zKey);
+        return rc;
+    }
+    sqlite3_randomness(sizeof(iRandom), &iRandom);
+    zTmp = sqlite3_mprintf("%s-%016llx", zPath, iRandom);
+    if (zTmp == 0) {
+        sqlite3_free(zKey);
+        sqlite3_free(zPath);
+        return SQLITE_NOMEM;
+    }
+
+    nKey = (sqlite3_int64)strlen(zKey);
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.zMagic, BFSVTAB_MAP_MAGIC, sizeof(BFSVTAB_MAP_MAGIC) - 1);
+    hdr.iByteOrder = 1;
+    memcpy(hdr.aCounter, aCounter, 4);
+    hdr.nKey = (unsigned int)nKey;
+    hdr.bWeight = pCsr->aWeight != 0;
+    hdr.nNode = pCsr->nNode;
+    hdr.nEdge = pCsr->nEdge;
+    hdr.nSlot = pCsr->index.nSlot;
+    hdr.nEntry = pCsr->index.nEntry;
+    hdr.bEmpty = pCsr->index.bEmpty;
+    hdr.iEmptyValue = pCsr->index.sEmpty.value;
+
+    pOut = fopen(zTmp, "wb");
+    bOk = pOut != 0;
+    if (bOk) {
+        sqlite3_int64 nTarget = pCsr->nEdge * (sqlite3_int64)sizeof(unsigned int);
+        bOk = fwrite(&hdr, sizeof(hdr), 1, pOut) == 1
+            && fwrite(zKey, 1, (size_t)nKey, pOut) == (size_t)nKey
+            && fwrite(aZero, 1, (size_t)(BFSVTAB_PAD8(nKey) - nKey), pOut)
+               == (size_t)(BFSVTAB_PAD8(nKey) - nKey)
+            && fwrite(pCsr->aId, sizeof(sqlite3_int64), (size_t)pCsr->nNode, pOut)
+               == (size_t)pCsr->nNode
+            && fwrite(pCsr->aOffset, sizeof(sqlite3_int64), (size_t)pCsr->nNode + 1, pOut)
+               == (size_t)pCsr->nNode + 1
+            && fwrite(pCsr->aTarget, 1, (size_t)nTarget, pOut) == (size_t)nTarget
+            && fwrite(aZero, 1, (size_t)(BFSVTAB_PAD8(nTarget) - nTarget), pOut)
+               == (size_t)(BFSVTAB_PAD8(nTarget) - nTarget)
+            && (pCsr->aWeight == 0
+                || fwrite(pCsr->aWeight, sizeof(double), (size_t)pCsr->nEdge, pOut)
+                   == (size_t)pCsr->nEdge)
+            && fwrite(pCsr->index.aSlot, sizeof(bfsvtab_hash_entry),
+                      (size_t)pCsr->index.nSlot, pOut) == (size_t)pCsr->index.nSlot;
+        bOk = (fclose(pOut) == 0) && bOk;
+    }
+    if (bOk == 0 || rename(zTmp, zPath) != 0) {
+        remove(zTmp);
+    }
+    sqlite3_free(zTmp);
+    sqlite3_free(zPath);
+    sqlite3_free(zKey);
+    return SQLITE_OK;
+#else
+    (void)pVtab;
+    (void)p;
+    return SQLITE_OK;
+#endif
+}
+
+/*
+** End of the mapped adjacency
+******************************************************************************/
+
+/******************************************************************************
+** Shared adjacency
+**
+** With adjacency = 'shared', an in-memory adjacency is also offered to
+** the other connections of the process, through a cache that every
+** connection which registered the module holds as the module's client
+** data.  A connection that needs the same edge relation of the same
+** database file then takes a reference to the adjacency in the cache
+** instead of building a copy of its own.
+**
+** A cache entry is found by the name of the database file and the edge
+** relation, and is only used while the file change counter of the
+** database (see bfsvtabFileCounter()) is still the one it records.  So,
+** as for adjacency = 'mapped', nothing is shared in WAL mode or exclusive
+** locking mode, for in-memory and temporary databases, or inside a
+** transaction.  The edge
+** table must also be a table of the main database that no temp table of
+** the same name hides.
+**
+** An adjacency is never changed once it is in the cache.  A connection
+** that finds the database changed builds a new one and swaps it in for
+** the old one, which the connections still traversing it keep alive with
+** their references.  So the mutex of the cache only has to be held while
+** its entries are looked up or replaced, and while a reference count or
+** the reverse arrays of one of its adjacencies change.
+*/
+struct bfsvtab_shared_entry {
+    char *zKey;                 /* Database file name and edge relation */
+    unsigned char aCounter[4];  /* File change counter when built */
+    bfsvtab_csr *pCsr;          /* The adjacency, with pShared set */
+    bfsvtab_shared_entry *pNext;    /* Next entry, most recently used first */
+};
+
+/* Maximum number of entries kept in the shared cache */
+#define BFSVTAB_MAX_SHARED 16
+
+/* The shared cache, while any connection has registered the module */
+static bfsvtab_shared *bfsvtabSharedCache = 0;
+
+/*
+** Return a new reference to the shared cache, creating it if no other
+** connection holds one, or NULL if out of memory.  The reference is
+** dropped by bfsvtabSharedRelease().
+*/
+static bfsvtab_shared *bfsvtabSharedAcquire(void) {
+    sqlite3_mutex *pMain = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_MAIN);
+    bfsvtab_shared *p;
+
+    sqlite3_mutex_enter(pMain);
+    p = bfsvtabSharedCache;
+    if (p == 0) {
+        p = sqlite3_malloc(sizeof(*p));
+        if (p) {
+            memset(p, 0, sizeof(*p));
+            p->mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+            if (p->mutex == 0 && sqlite3_threadsafe()) {
+                sqlite3_free(p);
+                p = 0;
+            }
+            bfsvtabSharedCache = p;
+        }
+    }
+    if (p) {
+        p->nRef++;
+    }
+    sqlite3_mutex_leave(pMain);
+    return p;
+}
+
+/*
+** Free a shared cache entry, dropping its reference to the adjacency.
+** The mutex of the cache must not be held.
+*/
+static void bfsvtabSharedEntryFree(bfsvtab_shared_entry *pEntry) {
+    sqlite3_free(pEntry->zKey);
+    bfsvtabCsrUnref(pEntry->pCsr);
+    sqlite3_free(pEntry);
+}
+
+/*
+** Drop a reference to the shared cache taken by bfsvtabSharedAcquire().
+** This is the destructor of the module's client data, so it runs as a
+** connection closes, after its virtual tables have been disconnected.
+*/
+static void bfsvtabSharedRelease(void *pArg) {
+    sqlite3_mutex *pMain = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_MAIN);
+    bfsvtab_shared *p = (bfsvtab_shared*)pArg;
+
+    sqlite3_mutex_enter(pMain);
+    if (--p->nRef == 0) {
+        /* No other connection can reach the cache any more */
+        while (p->pEntry) {
+            bfsvtab_shared_entry *pNext = p->pEntry->pNext;
+            bfsvtabSharedEntryFree(p->pEntry);
+            p->pEntry = pNext;
+        }
+        sqlite3_mutex_free(p->mutex);
+        sqlite3_free(p);
+        bfsvtabSharedCache = 0;
+    }
+    sqlite3_mutex_leave(pMain);
+}
+
+/*
+** Set *pzKey to the key of the shared cache entry for the edge relation
+** of cache entry p, and aCounter[] to the file change counter of the
+** database, or *pzKey to NULL if the relation cannot be shared.  The
+** caller must free *pzKey.  The read transaction opened by p->pProbe must
+** still be open.
+*/
+static int bfsvtabSharedKey(
+    bfsvtab_vtab *pVtab,
+    bfsvtab_cache *p,
+    char **pzKey,
+    unsigned char *aCounter
+) {
+    const char *zFile = bfsvtabFileCounter(pVtab->db, aCounter);
+    char *zRelation;
+    int bMain = 0;
+    int rc;
+
+    *pzKey = 0;
+    if (zFile == 0) {
+        return SQLITE_OK;
+    }
+    rc = bfsvtabIsMainTable(pVtab->db, p->zTableName, &bMain);
+    if (rc != SQLITE_OK || bMain == 0) {
+        return rc;
+    }
+    zRelation = bfsvtabRelationKey(p);
+    if (zRelation) {
+        *pzKey = sqlite3_mprintf("%s\n%s", zFile, zRelation);
+        sqlite3_free(zRelation);
+    }
+    return *pzKey ? SQLITE_OK : SQLITE_NOMEM;
+}
+
+/*
+** Set *ppCsr to the adjacency of the shared cache for the edge relation
+** of cache entry p, with a reference that the caller must release, if
+** there is one for the current content of the database.  Otherwise set
+** *ppCsr to NULL.
+*/
+static int bfsvtabSharedGet(
+    bfsvtab_vtab *pVtab,
+    bfsvtab_cache *p,
+    bfsvtab_csr **ppCsr
+) {
+    bfsvtab_shared *pShared = pVtab->pShared;
+    bfsvtab_shared_entry **pp;
+    bfsvtab_shared_entry *pEntry;
+    unsigned char aCounter[4];
+    char *zKey = 0;
+    int rc;
+
+    *ppCsr = 0;
+    rc = bfsvtabSharedKey(pVtab, p, &zKey, aCounter);
+    if (rc != SQLITE_OK || zKey == 0) {
+        return rc;
+    }
+    sqlite3_mutex_enter(pShared->mutex);
+    for (pp = &pShared->pEntry; (pEntry = *pp) != 0; pp = &pEntry->pNext) {
+        if (strcmp(pEntry->zKey, zKey) == 0) {
+            if (memcmp(pEntry->aCounter, aCounter, 4) == 0) {
+                /* Not bfsvtabCsrRef(), as the mutex is already held */
+                pEntry->pCsr->nRef++;
+                *ppCsr = pEntry->pCsr;
+                *pp = pEntry->pNext;
+                pEntry->pNext = pShared->pEntry;
+                pShared->pEntry = pEntry;
+            }
+            break;
+        }
+    }
+    sqlite3_mutex_leave(pShared->mutex);
+    sqlite3_free(zKey);
+    return SQLITE_OK;
+}
+
+/*
+** Put the adjacency of cache entry p, which is up to date with the
+** database, into the shared cache, in place of any older one for the same
+** relation.  The read transaction opened by p->pProbe must still be open,
+** so that the file change counter recorded is the one it was built from.
+*/
+static int bfsvtabSharedPut(bfsvtab_vtab *pVtab, bfsvtab_cache *p) {
+    bfsvtab_shared *pShared = pVtab->pShared;
+    bfsvtab_shared_entry **pp;
+    bfsvtab_shared_entry *pEntry;
+    bfsvtab_shared_entry *pEvict = 0;   /* Entries to free */
+    bfsvtab_csr *pOld = 0;
+    unsigned char aCounter[4];
+    char *zKey = 0;
+    int nEntry = 0;
+    int rc;
+
+    rc = bfsvtabSharedKey(pVtab, p, &zKey, aCounter);
+    if (rc != SQLITE_OK || zKey == 0) {
+        return rc;
+    }
+    sqlite3_mutex_enter(pShared->mutex);
+    for (pp = &pShared->pEntry; (pEntry = *pp) != 0; pp = &pEntry->pNext) {
+        if (strcmp(pEntry->zKey, zKey) == 0) {
+            *pp = pEntry->pNext;
+            pOld = pEntry->pCsr;
+            sqlite3_free(zKey);
+            break;
+        }
+    }
+    if (pEntry == 0) {
+        pEntry = sqlite3_malloc(sizeof(*pEntry));
+        if (pEntry == 0) {
+            sqlite3_mutex_leave(pShared->mutex);
+            sqlite3_free(zKey);
+            return SQLITE_NOMEM;
+        }
+        pEntry->zKey = zKey;
+    }
+    /* Only this thread can reach p->pCsr until it is in the cache */
+    p->pCsr->pShared = pShared;
+    p->pCsr->nRef++;
+    pEntry->pCsr = p->pCsr;
+    memcpy(pEntry->aCounter, aCounter, 4);
+    pEntry->pNext = pShared->pEntry;
+    pShared->pEntry = pEntry;
+
+    /* Drop the least recently used entries beyond BFSVTAB_MAX_SHARED */
+    for (pEntry = pShared->pEntry; pEntry; pEntry = pEntry->pNext) {
+        if (++nEntry == BFSVTAB_MAX_SHARED) {
+            pEvict = pEntry->pNext;
+            pEntry->pNext = 0;
+            break;
+        }
+    }
+    sqlite3_mutex_leave(pShared->mutex);
+
+    bfsvtabCsrUnref(pOld);
+    while (pEvict) {
+        pEntry = pEvict->pNext;
+        bfsvtabSharedEntryFree(pEvict);
+        pEvict = pEntry;
+    }
+    return SQLITE_OK;
+}
+
+/*
+** End of the shared adjacency
+******************************************************************************/
+
+/******************************************************************************
+** Incremental refresh
+**
+** With refresh = 'incremental', temp triggers on the edge table log each
+** row that this connection inserts, deletes or updates into the temp table
+** p->zLog of the cache entry, as rows of
+**
+**     (op, src, dst, weight)
+**
+** where op is 1 for an edge that was added and -1 for one that was
+** removed, so that an update is logged as both.  When the database has
+** changed since the adjacency was built but no other connection wrote to
+** it, the log holds every change to the edge relation, and applying it
+** with bfsvtabCsrPatch() costs far less than a new scan of the edge table.
+** Other connections fire no trigger here, so once PRAGMA data_version
+** shows that one has committed, the adjacency is rebuilt.
+**
+** SQLite only fires delete triggers for the rows removed by REPLACE
+** conflict resolution when PRAGMA recursive_triggers is on.  While it is
+** off, on a rowid table without UNIQUE indexes, where REPLACE can only
+** remove the row that has the rowid of the new one, BEFORE triggers log
+** that row with op 0 as it is about to be inserted or updated.  The AFTER
+** trigger that logs the change turns that entry into a removal (-1), and
+** one left behind, because the change was ignored or became an upsert,
+** is skipped.  On other tables an added edge is logged with op 2 instead
+** of 1 while recursive_triggers is off, and a log that holds such an
+** entry leads to a rebuild.
+**
+** The log and its triggers are named after the virtual table and the
+** relation, so that a later cache entry for the same pair, for example
+** after the schema was reloaded, takes them over.  The triggers are
+** dropped when the entry is evicted or the virtual table dropped, and
+** otherwise last until the connection closes.  Dropping the edge table
+** drops them too, and changes the schema, after which the log no longer
+** covers the relation.  So the log is only applied while all three
+** triggers exist and no schema has changed since it was emptied, and is
+** otherwise replaced by a rebuild that installs the triggers again.
+*/
+
+/*
+** Set *piVersion to the value of PRAGMA main.data_version.  Unlike the
+** data versions read by bfsvtabDataVersion(), it ignores the commits of
+** this connection.
+*/
+static int bfsvtabForeignVersion(sqlite3 *db, sqlite3_int64 *piVersion) {
+    sqlite3_stmt *pStmt = 0;
+    int rc = sqlite3_prepare_v2(db, "PRAGMA main.data_version", -1, &pStmt, 0);
+    if (rc == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW) {
+        *piVersion = sqlite3_column_int64(pStmt, 0);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_finalize(pStmt);
+    }
+    return rc;
+}
+
+/*
+** Set *piSchema to a hash of the schema versions of all databases but
+** temp, where the triggers themselves are created.
+*/
+static int bfsvtabSchemaVersion(sqlite3 *db, sqlite3_uint64 *piSchema) {
+    sqlite3_uint64 h = (((sqlite3_uint64)0xcbf29ce4)<<32) | 0x84222325;
+    sqlite3_stmt *pList = 0;
+    int rc = sqlite3_prepare_v2(db,
+        "SELECT name FROM pragma_database_list WHERE name != 'temp'",
+        -1, &pList, 0);
+    while (rc == SQLITE_OK && sqlite3_step(pList) == SQLITE_ROW) {
+        const char *zDb = (const char*)sqlite3_column_text(pList, 0);
+        sqlite3_stmt *pStmt = 0;
+        rc = bfsvtabPreparef(db, &pStmt, "PRAGMA \"%w\".schema_version", zDb);
+        if (rc == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW) {
+            h = (h ^ bfsvtabHashString(zDb)) * ((((sqlite3_uint64)0x100)<<32) | 0x1b3);
+            h = (h ^ (sqlite3_uint64)sqlite3_column_int64(pStmt, 0))
+              * ((((sqlite3_uint64)0x100)<<32) | 0x1b3);
+        }
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_finalize(pStmt);
+        }
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_finalize(pList);
+    } else {
+        sqlite3_finalize(pList);
+    }
+    *piSchema = h;
+    return rc;
+}
+
+/*
+** Set *pbIntact to true if the triggers of cache entry p all exist and no
+** schema has changed since its log was emptied, so that the log holds
+** every change made to the edge relation by this connection since.
+*/
+static int bfsvtabLogIntact(sqlite3 *db, bfsvtab_cache *p, int *pbIntact) {
+    sqlite3_stmt *pStmt = 0;
+    sqlite3_uint64 iSchema = 0;
+    int rc;
+
+    *pbIntact = 0;
+    rc = bfsvtabPreparef(db, &pStmt,
+        "SELECT count(*) FROM temp.sqlite_master WHERE type = 'trigger'"
+        " AND name IN ('%q_insert', '%q_delete', '%q_update',"
+        " '%q_before_insert', '%q_before_update')",
+        p->zLog, p->zLog, p->zLog, p->zLog, p->zLog);
+    if (rc == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW) {
+        *pbIntact = sqlite3_column_int(pStmt, 0) == (p->bRowid ? 5 : 3);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_finalize(pStmt);
+    }
+    if (rc == SQLITE_OK && *pbIntact) {
+        rc = bfsvtabSchemaVersion(db, &iSchema);
+        *pbIntact = rc == SQLITE_OK && iSchema == p->iSchema;
+    }
+    return rc;
+}
+
+/*
+** Drop the triggers of cache entry p and empty its log.  The log table
+** itself is left behind, as DROP TABLE fails while a statement runs.
+*/
+static void bfsvtabLogDrop(sqlite3 *db, bfsvtab_cache *p) {
+    if (p->zLog) {
+        bfsvtabExecf(db,
+            "DROP TRIGGER IF EXISTS temp.\"%w_insert\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_delete\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_update\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_before_insert\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_before_update\";"
+            "DELETE FROM temp.\"%w\";",
+            p->zLog, p->zLog, p->zLog, p->zLog, p->zLog, p->zLog);
+        sqlite3_free(p->zLog);
+        p->zLog = 0;
+    }
+}
+
+/*
+** Append to pStr the WHEN clause of the update triggers of cache entry p
+** on a rowid table, which fire when the update moves the row to another
+** rowid or changes a column of the relation.
+*/
+static void bfsvtabLogWhen(sqlite3_str *pStr, bfsvtab_cache *p) {
+    sqlite3_str_appendf(pStr,
+        " WHEN new.rowid IS NOT old.rowid"
+        " OR new.\"%w\" IS NOT old.\"%w\" OR new.\"%w\" IS NOT old.\"%w\"",
+        p->zFromColumn, p->zFromColumn, p->zToColumn, p->zToColumn);
+    if (p->zWeightColumn[0]) {
+        sqlite3_str_appendf(pStr, " OR new.\"%w\" IS NOT old.\"%w\"",
+                            p->zWeightColumn, p->zWeightColumn);
+    }
+}
+
+/*
+** Start logging the changes to the edge relation of cache entry p, whose
+** adjacency has just been built, installing the triggers if necessary,
+** and empty the log.  If the triggers cannot be created, for example
+** because the edge table is a view, p is left without a log and is
+** rebuilt after every change.
+*/
+static int bfsvtabLogInstall(bfsvtab_vtab *pVtab, bfsvtab_cache *p) {
+    static const char *const azEvent[] = { "insert", "delete", "update" };
+    sqlite3_stmt *pStmt = 0;
+    sqlite3_str *pStr;
+    char *zSql;
+    int bWeight = p->zWeightColumn[0] != 0;
+    int bRowid = 0;                 /* REPLACE only removes rows by rowid */
+    int bBefore = 0;                /* The BEFORE triggers exist */
+    int i, j;
+    int rc;
+
+    if (p->zLog == 0) {
+        char *zKey = sqlite3_mprintf("%s.%s\n%s\n%s\n%s\n%s\n%d", pVtab->zDb,
+                pVtab->zSelf, p->zTableName, p->zFromColumn, p->zToColumn,
+                p->zWeightColumn, p->bBoth);
+        sqlite3_uint64 h;
+        if (zKey == 0) {
+            return SQLITE_NOMEM;
+        }
+        h = bfsvtabHashString(zKey);
+        sqlite3_free(zKey);
+        p->zLog = sqlite3_mprintf("bfsvtab_log_%016llx", h);
+        if (p->zLog == 0) {
+            return SQLITE_NOMEM;
+        }
+    }
+
+    /* A rowid table without a UNIQUE index, which a WITHOUT ROWID table
+    ** always has, can only lose rows to REPLACE through its rowid */
+    rc = bfsvtabPreparef(pVtab->db, &pStmt,
+        "SELECT EXISTS (SELECT 1 FROM pragma_table_info(?1))"
+        " AND NOT EXISTS (SELECT 1 FROM pragma_index_list(?1) WHERE \"unique\"),"
+        " EXISTS (SELECT 1 FROM temp.sqlite_master WHERE type = 'trigger'"
+        " AND name = '%q_before_insert')", p->zLog);
+    if (rc == SQLITE_OK) {
+        sqlite3_bind_text(pStmt, 1, p->zTableName, -1, SQLITE_STATIC);
+        if (sqlite3_step(pStmt) == SQLITE_ROW) {
+            bRowid = sqlite3_column_int(pStmt, 0);
+            bBefore = sqlite3_column_int(pStmt, 1);
+        }
+        rc = sqlite3_finalize(pStmt);
+    }
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    pStr = sqlite3_str_new(pVtab->db);
+    sqlite3_str_appendf(pStr,
+        "CREATE TEMP TABLE IF NOT EXISTS \"%w\"(op INTEGER, src, dst, weight);"
+        "DELETE FROM temp.\"%w\";", p->zLog, p->zLog);
+    if (bBefore != bRowid) {
+        /* Made for the other kind of table, before a schema change */
+        sqlite3_str_appendf(pStr,
+            "DROP TRIGGER IF EXISTS temp.\"%w_insert\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_update\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_before_insert\";"
+            "DROP TRIGGER IF EXISTS temp.\"%w_before_update\";",
+            p->zLog, p->zLog, p->zLog, p->zLog);
+    }
+    for (i = 0; i < 3; i++) {
+        sqlite3_str_appendf(pStr,
+            "CREATE TEMP TRIGGER IF NOT EXISTS \"%w_%s\" AFTER %s",
+            p->zLog, azEvent[i], azEvent[i]);
+        if (i == 2 && bRowid == 0) {
+            sqlite3_str_appendf(pStr, " OF \"%w\", \"%w\"",
+                                p->zFromColumn, p->zToColumn);
+            if (bWeight) {
+                sqlite3_str_appendf(pStr, ", \"%w\"", p->zWeightColumn);
+            }
+        }
+        sqlite3_str_appendf(pStr, " ON \"%w\"", p->zTableName);
+        if (i == 2 && bRowid) {
+            bfsvtabLogWhen(pStr, p);
+        }
+        sqlite3_str_appendall(pStr, " BEGIN");
+        if (i != 1 && bRowid) {
+            /* The row was stored, so REPLACE did remove the pending one */
+            sqlite3_str_appendf(pStr,
+                " UPDATE \"%w\" SET op = -1"
+                " WHERE rowid = (SELECT max(rowid) FROM \"%w\") AND op = 0;",
+                p->zLog, p->zLog);
+        }
+        for (j = 0; j < 2; j++) {
+            /* The old row is removed (j==0), the new one added (j==1) */
+            const char *zRow = j ? "new" : "old";
+            if (i == j) {
+                continue;
+            }
+            sqlite3_str_appendf(pStr,
+                " INSERT INTO \"%w\" VALUES(%s, %s.\"%w\", %s.\"%w\", ",
+                p->zLog, j == 0 ? "-1" : bRowid ? "1" :
+                         "(SELECT 2 - recursive_triggers"
+                         " FROM pragma_recursive_triggers)",
+                zRow, p->zFromColumn, zRow, p->zToColumn);
+            if (bWeight) {
+                sqlite3_str_appendf(pStr, "%s.\"%w\");", zRow, p->zWeightColumn);
+            } else {
+                sqlite3_str_appendall(pStr, "NULL);");
+            }
+        }
+        sqlite3_str_appendall(pStr, " END;");
+    }
+    for (i = 0; bRowid && i < 3; i += 2) {
+        /* The row that REPLACE would remove, if the change is stored */
+        sqlite3_str_appendf(pStr,
+            "CREATE TEMP TRIGGER IF NOT EXISTS \"%w_before_%s\" BEFORE %s"
+            " ON \"%w\"", p->zLog, azEvent[i], azEvent[i], p->zTableName);
+        if (i == 2) {
+            bfsvtabLogWhen(pStr, p);
+        }
+        sqlite3_str_appendf(pStr,
+            " BEGIN"
+            " DELETE FROM \"%w\""
+            " WHERE rowid = (SELECT max(rowid) FROM \"%w\") AND op = 0;"
+            " INSERT INTO \"%w\" SELECT %s, \"%w\", \"%w\", %s%w%s FROM \"%w\""
+            " WHERE rowid = new.rowid%s"
+            " AND NOT (SELECT recursive_triggers FROM pragma_recursive_triggers);"
+            " END;",
+            p->zLog, p->zLog, p->zLog,
+            i ? "0" : "CASE WHEN new.rowid = -1 THEN 2 ELSE 0 END",
+            p->zFromColumn, p->zToColumn,
+            bWeight ? "\"" : "NULL", bWeight ? p->zWeightColumn : "",
+            bWeight ? "\"" : "", p->zTableName,
+            i ? " AND new.rowid IS NOT old.rowid" : "");
+    }
+    zSql = sqlite3_str_finish(pStr);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = sqlite3_exec(pVtab->db, zSql, 0, 0, 0);
+    sqlite3_free(zSql);
+    p->bRowid = bRowid;
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabForeignVersion(pVtab->db, &p->iForeign);
+    }
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabSchemaVersion(pVtab->db, &p->iSchema);
+    }
+    if (rc != SQLITE_OK) {
+        bfsvtabLogDrop(pVtab->db, p);
+        if (rc != SQLITE_NOMEM) {
+            rc = SQLITE_OK;
+        }
+    }
+    return rc;
+}
+
+/*
+** Apply the changes in the log of cache entry p to its adjacency.  If
+** ppCsr is NULL, the entry itself is updated and the log emptied.
+** Otherwise a transaction is open and a later ROLLBACK may undo the
+** changes, so *ppCsr is set to an updated copy, with one reference that
+** the caller must release, and the entry and its log are left as they
+** are.  *pbApplied is set to false, and nothing is changed, if the log
+** may miss rows removed by REPLACE, or is no longer intact (see
+** bfsvtabLogIntact()).
+**
+** Rows of the log that bfsvtabCsrBuild() would have skipped, because
+** a node or the weight is of the wrong type, are skipped here too.
+*/
+static int bfsvtabLogApply(
+    bfsvtab_vtab *pVtab,
+    bfsvtab_cache *p,
+    bfsvtab_csr **ppCsr,
+    int *pbApplied
+) {
+    sqlite3_stmt *pStmt = 0;
+    bfsvtab_delta *aDelta = 0;
+    sqlite3_int64 nDelta = 0;
+    sqlite3_int64 nAlloc = 0;
+    sqlite3_int64 iLast = 0;        /* Rowid of the last row of the log */
+    int bWeight = p->zWeightColumn[0] != 0;
+    int bIntact = 0;
+    int rc;
+
+    *pbApplied = 0;
+    rc = bfsvtabLogIntact(pVtab->db, p, &bIntact);
+    if (rc != SQLITE_OK || bIntact == 0) {
+        return rc;
+    }
+    rc = bfsvtabPreparef(pVtab->db, &pStmt,
+        "SELECT rowid, op, src, dst, weight FROM temp.\"%w\" ORDER BY rowid",
+        p->zLog);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    while (sqlite3_step(pStmt) == SQLITE_ROW) {
+        iLast = sqlite3_column_int64(pStmt, 0);
+        if (sqlite3_column_int(pStmt, 1) == 0) {
+            /* A row that REPLACE would have removed, but did not */
+            continue;
+        }
+        if (sqlite3_column_int(pStmt, 1) > 1) {
+            sqlite3_free(aDelta);
+            return sqlite3_finalize(pStmt);
+        }
+        if (sqlite3_column_type(pStmt, 2) != SQLITE_INTEGER
+            || sqlite3_column_type(pStmt, 3) != SQLITE_INTEGER
+            || (bWeight && bfsvtabIsNumber(pStmt, 4) == 0)) {
+            continue;
+        }
+        if (nDelta >= nAlloc) {
+            sqlite3_int64 nNew = nAlloc ? nAlloc * 2 : 64;
+            bfsvtab_delta *aNew = sqlite3_realloc64(aDelta, nNew * sizeof(bfsvtab_delta));
+            if (aNew == 0) {
+                sqlite3_finalize(pStmt);
+                sqlite3_free(aDelta);
+                return SQLITE_NOMEM;
+            }
+            aDelta = aNew;
+            nAlloc = nNew;
+        }
+        aDelta[nDelta].iFrom = sqlite3_column_int64(pStmt, 2);
+        aDelta[nDelta].iTo = sqlite3_column_int64(pStmt, 3);
+        aDelta[nDelta].iSeq = nDelta;
+        aDelta[nDelta].rWeight = bWeight ? sqlite3_column_double(pStmt, 4) : 0.0;
+        aDelta[nDelta].bInsert = sqlite3_column_int(pStmt, 1) > 0;
+        nDelta++;
+    }
+    rc = sqlite3_finalize(pStmt);
+
+    if (rc == SQLITE_OK && ppCsr) {
+        bfsvtabCsrRef(p->pCsr);
+        if (nDelta == 0) {
+            *ppCsr = p->pCsr;
+        } else {
+            rc = bfsvtabCsrPatch(p->pCsr, aDelta, nDelta, p->bBoth, ppCsr);
+        }
+    } else if (rc == SQLITE_OK && nDelta > 0) {
+        bfsvtab_csr *pOld = p->pCsr;
+        p->pCsr = 0;
+        p->bMapped = 0;
+        p->bShared = 0;
+        rc = bfsvtabCsrPatch(pOld, aDelta, nDelta, p->bBoth, &p->pCsr);
+    }
+    sqlite3_free(aDelta);
+    if (rc == SQLITE_OK && ppCsr == 0 && iLast > 0) {
+        rc = bfsvtabExecf(pVtab->db,
+            "DELETE FROM temp.\"%w\" WHERE rowid <= %lld", p->zLog, iLast);
+    }
+    *pbApplied = rc == SQLITE_OK;
+    return rc;
+}
+
+/*
+** End of the incremental refresh
+******************************************************************************/
+
+/*
+** The bfsvtabConnect() method is invoked to create a new
+** bfs virtual table.
+**
+** Think of this routine as the constructor for bfsvtab_vtab objects.
+**
+** All this routine needs to do is:
+**
+**    (1) Allocate the bfsvtab_vtab object and initialize all fields.
+**
+**    (2) Tell SQLite (via the sqlite3_declare_vtab() interface) what the
+**        result set of queries against the virtual table will look like.
+*/
+static int bfsvtabConnect(
+    sqlite3 *db,
+    void *pAux,
+    int argc, const char *const*argv,
+    sqlite3_vtab **ppVtab,
+    char **pzErr
+) {
+    bfsvtab_vtab *pNew;
+    int i;
+    int rc;
+    const char *zVal;
+
+    *ppVtab = 0;
+    rc = SQLITE_OK;
+
+    pNew = sqlite3_malloc(sizeof(*pNew));
+    if (pNew == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(pNew, 0, sizeof(*pNew));
+
+    pNew->db = db;
+    pNew->pShared = (bfsvtab_shared*)pAux;
+    pNew->nBatch = 1;
+    pNew->nThread = 1;
+    pNew->zDb = sqlite3_mprintf("%s", argv[1]);
+    if (pNew->zDb == 0) {
+        rc = SQLITE_NOMEM;
+        goto connectError;
+    }
+
+    pNew->zSelf = sqlite3_mprintf("%s", argv[2]);
+    if (pNew->zSelf == 0) {
+        rc = SQLITE_NOMEM;
+        goto connectError;
+    }
+    /* Only the eponymous table, named after the module, has none */
+    pNew->bShadow = argc > 3 || strcmp(argv[0], argv[2]) != 0;
+
+    for (i = 3; i < argc; i++) {
+        zVal = bfsvtabValueOfKey("tablename", argv[i]);
+        if (zVal) {
+            sqlite3_free(pNew->zTableName);
+            pNew->zTableName = bfsvtabDequote(zVal);
+            if (pNew->zTableName == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("fromcolumn", argv[i]);
+        if (zVal) {
+            sqlite3_free(pNew->zFromColumn);
+            pNew->zFromColumn = bfsvtabDequote(zVal);
+            if (pNew->zFromColumn == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("tocolumn", argv[i]);
+        if (zVal) {
+            sqlite3_free(pNew->zToColumn);
+            pNew->zToColumn = bfsvtabDequote(zVal);
+            if (pNew->zToColumn == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("weightcolumn", argv[i]);
+        if (zVal) {
+            sqlite3_free(pNew->zWeightColumn);
+            pNew->zWeightColumn = bfsvtabDequote(zVal);
+            if (pNew->zWeightColumn == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("heuristic", argv[i]);
+        if (zVal) {
+            sqlite3_free(pNew->zHeuristic);
+            pNew->zHeuristic = bfsvtabDequote(zVal);
+            if (pNew->zHeuristic == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("batchsize", argv[i]);
+        if (zVal) {
+            char *zBatch = bfsvtabDequote(zVal);
+            if (zBatch == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->nBatch = atoi(zBatch);
+            sqlite3_free(zBatch);
+            if (pNew->nBatch < 1) {
+                *pzErr = sqlite3_mprintf("batchsize must be a positive integer");
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("adjacency", argv[i]);
+        if (zVal) {
+            char *zMode = bfsvtabDequote(zVal);
+            if (zMode == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->eAdjacency = bfsvtabAdjacencyMode(zMode);
+            sqlite3_free(zMode);
+            if (pNew->eAdjacency < 0) {
+                *pzErr = sqlite3_mprintf("unknown adjacency: [%s]", zVal);
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("threads", argv[i]);
+        if (zVal) {
+            char *zThreads = bfsvtabDequote(zVal);
+            if (zThreads == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->nThread = atoi(zThreads);
+            sqlite3_free(zThreads);
+            if (pNew->nThread < 1) {
+                *pzErr = sqlite3_mprintf("threads must be a positive integer");
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("memlimit", argv[i]);
+        if (zVal) {
+            char *zLimit = bfsvtabDequote(zVal);
+            if (zLimit == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->nMemLimit = strtoll(zLimit, 0, 10);
+            sqlite3_free(zLimit);
+            if (pNew->nMemLimit < 0) {
+                *pzErr = sqlite3_mprintf("memlimit must not be negative");
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("visited", argv[i]);
+        if (zVal) {
+            char *zMode = bfsvtabDequote(zVal);
+            if (zMode == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->eVisited = bfsvtabVisitedMode(zMode);
+            sqlite3_free(zMode);
+            if (pNew->eVisited < 0) {
+                *pzErr = sqlite3_mprintf("unknown visited: [%s]", zVal);
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("sources", argv[i]);
+        if (zVal) {
+            char *zMode = bfsvtabDequote(zVal);
+            if (zMode == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->eSources = bfsvtabSourcesMode(zMode);
+            sqlite3_free(zMode);
+            if (pNew->eSources < 0) {
+                *pzErr = sqlite3_mprintf("unknown sources: [%s]", zVal);
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("direction", argv[i]);
+        if (zVal) {
+            char *zMode = bfsvtabDequote(zVal);
+            if (zMode == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->eDirection = bfsvtabDirectionMode(zMode);
+            sqlite3_free(zMode);
+            if (pNew->eDirection < 0) {
+                *pzErr = sqlite3_mprintf("unknown direction: [%s]", zVal);
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("refresh", argv[i]);
+        if (zVal) {
+            char *zMode = bfsvtabDequote(zVal);
+            if (zMode == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->eRefresh = bfsvtabRefreshMode(zMode);
+            sqlite3_free(zMode);
+            if (pNew->eRefresh < 0) {
+                *pzErr = sqlite3_mprintf("unknown refresh: [%s]", zVal);
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        zVal = bfsvtabValueOfKey("engine", argv[i]);
+        if (zVal) {
+            char *zMode = bfsvtabDequote(zVal);
+            if (zMode == 0) {
+                rc = SQLITE_NOMEM;
+                goto connectError;
+            }
+            pNew->eEngine = bfsvtabEngineMode(zMode);
+            sqlite3_free(zMode);
+            if (pNew->eEngine < 0) {
+                *pzErr = sqlite3_mprintf("unknown engine: [%s]", zVal);
+                bfsvtabFree(pNew);
+                return SQLITE_ERROR;
+            }
+            continue;
+        }
+        *pzErr = sqlite3_mprintf("unrecognized argument: [%s]\n", argv[i]);
+        bfsvtabFree(pNew);
+        return SQLITE_ERROR;
+    }
+
+    rc = sqlite3_declare_vtab(db,
+       "CREATE TABLE x(id,parent,distance,shortest_path,root HIDDEN,"
+                       "tablename HIDDEN,fromcolumn HIDDEN,"
+                       "tocolumn HIDDEN,batchsize HIDDEN,adjacency HIDDEN,"
+                       "engine HIDDEN,threads HIDDEN,visited HIDDEN,"
+                       "sources HIDDEN,hops HIDDEN,weightcolumn HIDDEN,"
+                       "heuristic HIDDEN,direction HIDDEN,refresh HIDDEN,"
+                       "memlimit HIDDEN,command HIDDEN)"
+    );
+    /* For convenience, define symbolic names for the index to each column. */
+#define BFSVTAB_COL_ID              0
+#define BFSVTAB_COL_PARENT          1
+#define BFSVTAB_COL_DISTANCE        2
+#define BFSVTAB_COL_SHORTEST_PATH   3
+#define BFSVTAB_COL_ROOT            4
+#define BFSVTAB_COL_TABLENAME       5
+#define BFSVTAB_COL_FROMCOLUMN      6
+#define BFSVTAB_COL_TOCOLUMN        7
+#define BFSVTAB_COL_BATCHSIZE       8
+#define BFSVTAB_COL_ADJACENCY       9
+#define BFSVTAB_COL_ENGINE          10
+#define BFSVTAB_COL_THREADS         11
+#define BFSVTAB_COL_VISITED         12
+#define BFSVTAB_COL_SOURCES         13
+#define BFSVTAB_COL_HOPS            14
+#define BFSVTAB_COL_WEIGHTCOLUMN    15
+#define BFSVTAB_COL_HEURISTIC       16
+#define BFSVTAB_COL_DIRECTION       17
+#define BFSVTAB_COL_REFRESH         18
+#define BFSVTAB_COL_MEMLIMIT        19
+#define BFSVTAB_COL_COMMAND         20
+#define BFSVTAB_NCOLUMN             21
+    if (rc != SQLITE_OK) {
+        bfsvtabFree(pNew);
+    }
+    *ppVtab = (sqlite3_vtab*)pNew;
+    return rc;
+
+connectError:
+    bfsvtabFree(pNew);
+    return rc;
+}
+
+/*
+** This method is the destructor for bfsvtab_vtab objects.
+*/
+static int bfsvtabDisconnect(sqlite3_vtab *pVtab) {
+    bfsvtab_vtab *p = (bfsvtab_vtab*)pVtab;
+    bfsvtabFree(p);
+    return SQLITE_OK;
+}
+
+/*
+** Drop the triggers that clear the stamp of the stored adjacency of p,
+** which must go before the stamp table they write to.
+*/
+static int bfsvtabStampDrop(bfsvtab_vtab *p) {
+    int rc = SQLITE_OK;
+    int i;
+    for (i = 0; rc == SQLITE_OK && p->bShadow && i < 3; i++) {
+        rc = bfsvtabExecf(p->db, "DROP TRIGGER IF EXISTS \"%w\".\"%w_stamp_%s\"",
+                          p->zDb, p->zSelf, azBfsvtabStampEvent[i]);
+    }
+    return rc;
+}
+
+/*
+** The xDestroy method.  Drops the shadow tables, then disconnects.
+*/
+static int bfsvtabDestroy(sqlite3_vtab *pVtab) {
+    bfsvtab_vtab *p = (bfsvtab_vtab*)pVtab;
+    int rc = SQLITE_OK;
+    bfsvtab_cache *pEntry;
+    int i;
+    for (pEntry = p->pCache; pEntry; pEntry = pEntry->pNext) {
+        bfsvtabLogDrop(p->db, pEntry);
+    }
+    rc = bfsvtabStampDrop(p);
+    for (i = 0; rc == SQLITE_OK && p->bShadow && i < BFSVTAB_NSTORED; i++) {
+        rc = bfsvtabExecf(p->db, "DROP TABLE IF EXISTS \"%w\".\"%w_%s\"",
+                          p->zDb, p->zSelf, azBfsvtabShadow[i]);
+    }
+    if (rc == SQLITE_OK) {
+        bfsvtabFree(p);
+    }
+    return rc;
+}
+
+/*
+** The xRename method.  Renames the shadow tables along with the table.
+** The triggers are named after the old name, so they are dropped, which
+** leaves any stored adjacency out of date until the next rebuild.
+*/
+static int bfsvtabRename(sqlite3_vtab *pVtab, const char *zNew) {
+    bfsvtab_vtab *p = (bfsvtab_vtab*)pVtab;
+    char *zSelf;
+    int rc;
+    int i;
+    rc = bfsvtabStampDrop(p);
+    for (i = 0; rc == SQLITE_OK && p->bShadow && i < BFSVTAB_NSTORED; i++) {
+        char *zOld = sqlite3_mprintf("%s_%s", p->zSelf, azBfsvtabShadow[i]);
+        if (zOld == 0) {
+            return SQLITE_NOMEM;
+        }
+        if (sqlite3_table_column_metadata(p->db, p->zDb, zOld, 0, 0, 0, 0, 0, 0)
+            == SQLITE_OK) {
+            rc = bfsvtabExecf(p->db,
+                "ALTER TABLE \"%w\".\"%w\" RENAME TO \"%w_%s\"",
+                p->zDb, zOld, zNew, azBfsvtabShadow[i]);
+        }
+        sqlite3_free(zOld);
+    }
+    if (rc == SQLITE_OK) {
+        zSelf = sqlite3_mprintf("%s", zNew);
+        if (zSelf == 0) {
+            return SQLITE_NOMEM;
+        }
+        sqlite3_free(p->zSelf);
+        p->zSelf = zSelf;
+    }
+    return rc;
+}
+
+/*
+** The xShadowName method.  Return true if zName is the suffix of one of
+** the shadow tables, which SQLite then protects from ordinary SQL in
+** defensive mode.
+*/
+static int bfsvtabShadowName(const char *zName) {
+    int i;
+    for (i = 0; i < BFSVTAB_NSHADOW; i++) {
+        if (sqlite3_stricmp(zName, azBfsvtabShadow[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+** Constructor for a new bfsvtab_cursor object.
+*/
+static int bfsvtabOpen(sqlite3_vtab *p, sqlite3_vtab_cursor **ppCursor) {
+    bfsvtab_vtab *pVtab = (bfsvtab_vtab*)p;
+    bfsvtab_cursor *pCur;
+    pCur = sqlite3_malloc(sizeof(*pCur));
+    if (pCur == 0) {
+        return SQLITE_NOMEM;
+    }
+    memset(pCur, 0, sizeof(*pCur));
+    pCur->pVtab = pVtab;
+    queueReset(&pCur->pQueue);
+    pCur->aPath[0].iDistance = -1;
+    pCur->aPath[1].iDistance = -1;
+#ifdef BFSVTAB_USE_AVL
+    bfsvtabSlabInit(&pCur->avlSlab, sizeof(bfsvtab_avl));
+#endif
+    *ppCursor = &pCur->base;
+    return SQLITE_OK;
+}
+
+static void bfsvtabClearCursor(bfsvtab_cursor *pCur) {
+  bfsvtabVisitedClear(pCur);
+  queueClear(&pCur->pQueue);
+  bfsvtabBatchClear(&pCur->batch);
+  pCur->nPending = 0;
+  bfsvtabCsrUnref(pCur->pCsr);
+  pCur->pCsr = 0;
+  bfsvtabHashClear(&pCur->targets);
+  pCur->bTargets = 0;
+  pCur->nTarget = 0;
+  pCur->nTargetSeen = 0;
+  pCur->nTargetLeft = 0;
+  bfsvtabHashClear(&pCur->onPath);
+  pCur->bOnPath = 0;
+  bfsvtabDiroptFree(pCur->pDiropt);
+  pCur->pDiropt = 0;
+  bfsvtabMsbfsFree(pCur->pMsbfs);
+  pCur->pMsbfs = 0;
+  bfsvtabPathsClear(&pCur->aPath[0]);
+  bfsvtabPathsClear(&pCur->aPath[1]);
+  bfsvtabKeysClear(&pCur->roots);
+  pCur->iRoot = 0;
+
+  sqlite3_free(pCur->zTableName);
+  sqlite3_free(pCur->zFromColumn);
+  sqlite3_free(pCur->zToColumn);
+  sqlite3_free(pCur->zWeightColumn);
+  sqlite3_free(pCur->zHeuristic);
+  bfsvtabDijkstraFree(pCur->pDijkstra);
+  pCur->pDijkstra = 0;
+
+  bfsvtabStmtRelease(pCur->pVtab, pCur->pStmt);
+  bfsvtabStmtRelease(pCur->pVtab, pCur->pRevStmt);
+  bfsvtabStmtRelease(pCur->pVtab, pCur->pHeuristic);
+
+  pCur->pStmt = 0;
+  pCur->pRevStmt = 0;
+  pCur->pHeuristic = 0;
+  pCur->zTableName = 0;
+  pCur->zFromColumn = 0;
+  pCur->zToColumn = 0;
+  pCur->zWeightColumn = 0;
+  pCur->zHeuristic = 0;
+  pCur->pCurrent = 0;
+}
+
+/*
+** Destructor for a bfsvtab_cursor.
+*/
+static int bfsvtabClose(sqlite3_vtab_cursor *cur) {
+    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
+    bfsvtabClearCursor(pCur);
+    sqlite3_free(pCur);
+    return SQLITE_OK;
+}
+
+/*
+** Record that node iNew is a neighbour of pFrom.  If iNew has not been
+** visited yet, mark it visited and add it to the end of the queue.  When
+** the traversal is limited to the nodes on a shortest path, any other
+** node is ignored.
+*/
+static int bfsvtabDiscover(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 iFrom,
+    sqlite3_int64 iNew
+) {
+    int rc;
+    int bNew;
+
+    if (pCur->bOnPath && bfsvtabHashSearch(&pCur->onPath, iNew) == 0) {
+        return SQLITE_OK;
+    }
+    rc = bfsvtabVisitedAdd(pCur, iNew, iFrom, &bNew);
+    if (rc != SQLITE_OK || bNew == 0) {
+        return rc;
+    }
+    rc = queuePush(&pCur->pQueue, iNew);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    if (pCur->bTargets && bfsvtabIsTarget(pCur, iNew)) {
+        pCur->nTargetSeen++;
+    }
+    return SQLITE_OK;
+}
+
+/*
+** Expand pCur->pCurrent together with the nodes that follow it on the
+** queue at the same distance from the root, up to the batch size, using
+** a single statement of the form
+**
+**     SELECT from, to FROM tablename WHERE from IN (?1, ?2, ..., ?N)
+**
+** The rows are regrouped by source node in queue order before any new
+** node is discovered, so the traversal visits nodes in exactly the same
+** order as it would if each node were expanded by its own statement.
+*/
+static int bfsvtabExpandBatch(bfsvtab_cursor *pCur) {
+    bfsvtab_batch *p = &pCur->batch;
+    bfsvtab_hash_entry *pEntry;
+    sqlite3_int64 i;
+    int j;
+    int bNew;
+    int rc = SQLITE_OK;
+
+    bfsvtabHashReset(&p->pos);
+    p->nNode = 0;
+    p->nEdge = 0;
+    p->aNode[p->nNode++] = pCur->pCurrent->id;
+    /* The nodes of the next level stay on the queue, so that the
+    ** distances implied by queue position remain correct. */
+    for (i = 0; i < pCur->pQueue.nLevel && p->nNode < p->nMax; i++) {
+        p->aNode[p->nNode++] = queuePeek(&pCur->pQueue, i);
+    }
+    for (j = 0; rc == SQLITE_OK && j < p->nNode; j++) {
+        rc = bfsvtabHashInsert(&p->pos, p->aNode[j], j, &bNew);
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_bind_int64(pCur->pStmt, j + 1, p->aNode[j]);
+        }
+    }
+
+    while (rc == SQLITE_OK && sqlite3_step(pCur->pStmt) == SQLITE_ROW) {
+        if (sqlite3_column_type(pCur->pStmt, 1) != SQLITE_INTEGER) {
+            continue;
+        }
+        pEntry = bfsvtabHashSearch(&p->pos,
+                                   sqlite3_column_int64(pCur->pStmt, 0));
+        if (pEntry == 0) {
+            continue;
+        }
+        if (p->nEdge >= p->nEdgeAlloc) {
+            sqlite3_int64 nNew = p->nEdgeAlloc ? p->nEdgeAlloc * 2 : 256;
+            sqlite3_int64 *aNew;
+            aNew = sqlite3_realloc64(p->aEdge, nNew * 2 * sizeof(sqlite3_int64));
+            if (aNew == 0) {
+                rc = SQLITE_NOMEM;
+                break;
+            }
+            p->aEdge = aNew;
+            aNew = sqlite3_realloc64(p->aSorted, nNew * sizeof(sqlite3_int64));
+            if (aNew == 0) {
+                rc = SQLITE_NOMEM;
+                break;
+            }
+            p->aSorted = aNew;
+            p->nEdgeAlloc = nNew;
+        }
+        p->aEdge[p->nEdge * 2] = pEntry->value;
+        p->aEdge[p->nEdge * 2 + 1] = sqlite3_column_int64(pCur->pStmt, 1);
+        p->nEdge++;
+    }
+    sqlite3_clear_bindings(pCur->pStmt);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_reset(pCur->pStmt);
+    } else {
+        sqlite3_reset(pCur->pStmt);
+    }
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    /* Stable counting sort of the edges by source node.  Afterwards the
+    ** edges of aNode[j] start at aSorted[aEnd[j]] and run up to the
+    ** start of the next node's edges (or to nEdge for the last node). */
+    memset(p->aEnd, 0, p->nNode * sizeof(sqlite3_int64));
+    for (i = 0; i < p->nEdge; i++) {
+        p->aEnd[p->aEdge[i * 2]]++;
+    }
+    for (j = 1; j < p->nNode; j++) {
+        p->aEnd[j] += p->aEnd[j - 1];
+    }
+    for (i = p->nEdge - 1; i >= 0; i--) {
+        p->aSorted[--p->aEnd[p->aEdge[i * 2]]] = p->aEdge[i * 2 + 1];
+    }
+    for (j = 0; j < p->nNode; j++) {
+        sqlite3_int64 iEnd = j + 1 < p->nNode ? p->aEnd[j + 1] : p->nEdge;
+        for (i = p->aEnd[j]; i < iEnd; i++) {
+            rc = bfsvtabDiscover(pCur, p->aNode[j], p->aSorted[i]);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+    }
+    pCur->nPending = p->nNode - 1;
+    return SQLITE_OK;
+}
+
+/*
+** Find the neighbours of pCur->pCurrent and add those that have not been
+** visited yet to the queue.  Nodes at the maximum depth of the traversal
+** are not expanded, and nothing is expanded once every target node has
+** been visited.
+*/
+static int bfsvtabExpand(bfsvtab_cursor *pCur) {
+    int rc;
+    if (pCur->nPending > 0) {
+        /* This node was already expanded as part of an earlier batch */
+        pCur->nPending--;
+        return SQLITE_OK;
+    }
+    if (pCur->pCurrent->distance >= pCur->iMaxDepth
+        || (pCur->bTargets && pCur->nTargetSeen == pCur->nTarget)) {
+        return SQLITE_OK;
+    }
+    if (pCur->pCsr) {
+        bfsvtab_csr *pCsr = pCur->pCsr;
+        sqlite3_int64 iKey = pCur->pCurrent->id;
+        sqlite3_int64 i;
+        if (iKey < pCsr->nNode) {
+            for (i = pCsr->aOffset[iKey]; i < pCsr->aOffset[iKey + 1]; i++) {
+                rc = bfsvtabDiscover(pCur, iKey, pCsr->aTarget[i]);
+                if (rc != SQLITE_OK) {
+                    return rc;
+                }
+            }
+        }
+        return SQLITE_OK;
+    }
+    if (pCur->nBatch > 1) {
+        return bfsvtabExpandBatch(pCur);
+    }
+    rc = sqlite3_bind_int64(pCur->pStmt, 1, pCur->pCurrent->id);
+    if (rc) {
+        return rc;
+    }
+    while (rc == SQLITE_OK && sqlite3_step(pCur->pStmt) == SQLITE_ROW) {
+        if (sqlite3_column_type(pCur->pStmt, 0) == SQLITE_INTEGER) {
+            rc = bfsvtabDiscover(pCur, pCur->pCurrent->id,
+                                 sqlite3_column_int64(pCur->pStmt, 0));
+        }
+    }
+    if (rc) {
+        sqlite3_reset(pCur->pStmt);
+        return rc;
+    }
+    rc = sqlite3_clear_bindings(pCur->pStmt);
+    if (rc) {
+        return rc;
+    }
+    rc = sqlite3_reset(pCur->pStmt);
+    if (rc) {
+        return rc;
+    }
+    return rc;
+}
+
+/*
+** Return the number of bytes allocated for the state of the traversal of
+** pCur: the visited set, the queue or levels, and the parents and paths
+** kept for its rows.  The in-memory adjacency is not counted, as it is
+** shared with the cache of the virtual table and with other cursors.
+*/
+static sqlite3_int64 bfsvtabCursorMemory(bfsvtab_cursor *pCur) {
+    const sqlite3_int64 szEntry = sizeof(bfsvtab_hash_entry);
+    sqlite3_int64 n = 0;
+    int i;
+
+#ifdef BFSVTAB_USE_AVL
+    /* Items in use, as a whole chunk would exceed a small memlimit at once */
+    n += pCur->avlSlab.nItem * pCur->avlSlab.szItem;
+#else
+    n += pCur->visited.nSlot * szEntry;
+#endif
+    if (pCur->aDenseBit) {
+        n += ((pCur->nDense + 63) / 64) * sizeof(sqlite3_uint64);
+    }
+    if (pCur->aDenseParent) {
+        n += pCur->nDense * sizeof(sqlite3_int64);
+    }
+    n += pCur->pQueue.nAlloc * sizeof(sqlite3_int64);
+    n += pCur->batch.pos.nSlot * szEntry;
+    n += pCur->batch.nEdgeAlloc * 3 * sizeof(sqlite3_int64);
+    n += (pCur->targets.nSlot + pCur->onPath.nSlot) * szEntry;
+    n += pCur->roots.nAlloc * sizeof(sqlite3_int64);
+    for (i = 0; i < 2; i++) {
+        n += pCur->aPath[i].index.nSlot * szEntry + pCur->aPath[i].nAlloc;
+    }
+    if (pCur->pDiropt) {
+        bfsvtab_diropt *p = pCur->pDiropt;
+        sqlite3_int64 nWord = (p->nKey + 63) / 64;
+        n += nWord * sizeof(sqlite3_uint64);
+        n += p->aParent ? p->nKey * sizeof(sqlite3_int64)
+                        : nWord * sizeof(sqlite3_uint64);
+        n += p->aRank ? p->nKey * sizeof(sqlite3_uint64) : 0;
+        n += (p->level.nAlloc + p->next.nAlloc) * sizeof(sqlite3_int64);
+    }
+    if (pCur->pMsbfs) {
+        bfsvtab_msbfs *p = pCur->pMsbfs;
+        n += 3 * p->nKey * sizeof(sqlite3_uint64);
+        n += (p->prev.nAlloc + p->level.nAlloc) * sizeof(sqlite3_int64);
+    }
+    if (pCur->pDijkstra) {
+        bfsvtab_dijkstra *p = pCur->pDijkstra;
+        n += p->index.nSlot * szEntry;
+        n += p->nNodeAlloc * sizeof(bfsvtab_dijkstra_node);
+        n += p->nHeapAlloc * sizeof(bfsvtab_heap_entry);
+    }
+    return n;
+}
+
+/*
+** Fail the traversal of pCur if it holds more than its memlimit.  This is
+** reported as SQLITE_ERROR rather than SQLITE_NOMEM, which would make
+** SQLite roll back the whole transaction the query runs in.
+*/
+static int bfsvtabCheckMemory(bfsvtab_cursor *pCur) {
+    bfsvtab_vtab *pVtab = pCur->pVtab;
+    if (pCur->nMemLimit > 0 && bfsvtabCursorMemory(pCur) > pCur->nMemLimit) {
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "traversal needs more than memlimit = %lld bytes", pCur->nMemLimit);
+        return SQLITE_ERROR;
+    }
+    return SQLITE_OK;
+}
+
+/*
+** Advance a cursor using the direction-optimizing engine to its next row
+** of output.  The rows of each level are returned before the next level
+** is found.
+*/
+static int bfsvtabDiroptNext(bfsvtab_cursor *pCur) {
+    bfsvtab_diropt *p = pCur->pDiropt;
+    sqlite3_int64 iKey;
+    sqlite3_int64 i;
+    int rc;
+
+    while (pCur->bTargets == 0 || pCur->nTargetLeft > 0) {
+        if (p->iPos >= p->level.n) {
+            if (p->level.n == 0
+                || p->iDistance >= pCur->iMaxDepth
+                || (pCur->bTargets && pCur->nTargetSeen == pCur->nTarget)) {
+                break;
+            }
+            rc = bfsvtabDiroptStep(p, pCur->pCsr);
+            if (rc == SQLITE_OK) {
+                rc = bfsvtabCheckMemory(pCur);
+            }
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            for (i = 0; pCur->bTargets && i < p->level.n; i++) {
+                if (bfsvtabIsTarget(pCur, p->level.a[i])) {
+                    pCur->nTargetSeen++;
+                }
+            }
+            continue;
+        }
+        iKey = p->level.a[p->iPos++];
+        if (p->iDistance < pCur->iMinDepth || !bfsvtabIsTarget(pCur, iKey)) {
+            continue;
+        }
+        pCur->current.id = iKey;
+        pCur->current.parent = p->aParent ? p->aParent[iKey] : iKey;
+        pCur->current.distance = p->iDistance;
+        pCur->pCurrent = &pCur->current;
+        if (pCur->bTargets) {
+            pCur->nTargetLeft--;
+        }
+        return SQLITE_OK;
+    }
+    pCur->pCurrent = 0;
+    return SQLITE_OK;
+}
+
+/*
+** Move to the next row of a multi-source traversal.  The rows of each
+** node in the level are returned together, one per root that reached it.
+*/
+static int bfsvtabMsbfsNext(bfsvtab_cursor *pCur) {
+    bfsvtab_msbfs *p = pCur->pMsbfs;
+    sqlite3_int64 iKey;
+    sqlite3_uint64 m;
+    sqlite3_int64 i;
+    int rc;
+
+    while (pCur->bTargets == 0 || pCur->nTargetLeft > 0) {
+        if (p->mLeft == 0) {
+            if (p->iPos < p->level.n) {
+                iKey = p->level.a[p->iPos++];
+                if (p->iDistance >= pCur->iMinDepth && bfsvtabIsTarget(pCur, iKey)) {
+                    p->mLeft = p->aCur[iKey];
+                    p->iBit = 0;
+                }
+                continue;
+            }
+            if (p->level.n == 0
+                || p->iDistance >= pCur->iMaxDepth
+                || (pCur->bTargets && pCur->nTargetSeen == p->nPair)) {
+                break;
+            }
+            rc = bfsvtabMsbfsStep(p, pCur->pCsr);
+            if (rc == SQLITE_OK) {
+                rc = bfsvtabCheckMemory(pCur);
+            }
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            for (i = 0; pCur->bTargets && i < p->level.n; i++) {
+                if (bfsvtabIsTarget(pCur, p->level.a[i])) {
+                    for (m = p->aCur[p->level.a[i]]; m; m &= m - 1) {
+                        pCur->nTargetSeen++;
+                    }
+                }
+            }
+            continue;
+        }
+        while (((p->mLeft >> p->iBit) & 1) == 0) {
+            p->iBit++;
+        }
+        p->mLeft &= ~(((sqlite3_uint64)1) << p->iBit);
+        iKey = p->level.a[p->iPos - 1];
+        pCur->current.id = iKey;
+        pCur->current.parent = pCur->bParent ?
+                bfsvtabMsbfsParent(p, pCur->pCsr, iKey, p->iBit) : iKey;
+        pCur->current.distance = p->iDistance;
+        pCur->pCurrent = &pCur->current;
+        if (pCur->bTargets) {
+            pCur->nTargetLeft--;
+        }
+        return SQLITE_OK;
+    }
+    pCur->pCurrent = 0;
+    return SQLITE_OK;
+}
+
+/*
+** Record a path of weight rCost and nHop edges to node iKey through node
+** iParent.  In an A* search, the heuristic function is called for nodes
+** that have not been reached before, with the node and the target as
+** arguments.  A result that is not a positive number counts as zero.  The
+** target itself is known to be zero away, so the function is not asked.
+*/
+static int bfsvtabDijkstraVisit(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 iKey,
+    sqlite3_int64 iParent,
+    double rCost,
+    sqlite3_int64 nHop
+) {
+    double rEstimate = 0.0;
+    int rc;
+
+    if (pCur->pHeuristic && bfsvtabIsTarget(pCur, iKey) == 0
+        && bfsvtabDijkstraFind(pCur->pDijkstra, iKey) == 0) {
+        sqlite3_bind_int64(pCur->pHeuristic, 1, bfsvtabNodeId(pCur, iKey));
+        if (sqlite3_step(pCur->pHeuristic) == SQLITE_ROW
+            && bfsvtabIsNumber(pCur->pHeuristic, 0)) {
+            rEstimate = sqlite3_column_double(pCur->pHeuristic, 0);
+            if (rEstimate < 0.0) {
+                rEstimate = 0.0;
+            }
+        }
+        rc = sqlite3_reset(pCur->pHeuristic);
+        if (rc != SQLITE_OK) {
+            sqlite3_free(pCur->pVtab->base.zErrMsg);
+            pCur->pVtab->base.zErrMsg = sqlite3_mprintf(
+                "%s", sqlite3_errmsg(pCur->pVtab->db));
+            return rc;
+        }
+    }
+    return bfsvtabDijkstraRelax(pCur->pDijkstra, iKey, iParent, rCost, nHop,
+                                rEstimate);
+}
+
+/*
+** Follow the edges out of node iKey, reached through a path of weight
+** rCost and nHop edges, and record the paths they make.  Without a weight
+** column, as in an A* search over plain edges, every edge weighs 1.
+*/
+static int bfsvtabDijkstraExpand(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 iKey,
+    double rCost,
+    sqlite3_int64 nHop
+) {
+    sqlite3_int64 iTo;
+    double rWeight = 1.0;
+    int bWeight;
+    int rc = SQLITE_OK;
+
+    if (pCur->pCsr) {
+        bfsvtab_csr *pCsr = pCur->pCsr;
+        sqlite3_int64 i;
+        if (iKey >= pCsr->nNode) {
+            return SQLITE_OK;
+        }
+        for (i = pCsr->aOffset[iKey]; rc == SQLITE_OK && i < pCsr->aOffset[iKey + 1]; i++) {
+            iTo = pCsr->aTarget[i];
+            if (pCsr->aWeight) {
+                rWeight = pCsr->aWeight[i];
+                if (rWeight < 0.0) {
+                    goto negativeWeight;
+                }
+            }
+            rc = bfsvtabDijkstraVisit(pCur, iTo, iKey, rCost + rWeight, nHop + 1);
+        }
+        return rc;
+    }
+    bWeight = sqlite3_column_count(pCur->pStmt) > 1;
+    rc = sqlite3_bind_int64(pCur->pStmt, 1, iKey);
+    while (rc == SQLITE_OK && sqlite3_step(pCur->pStmt) == SQLITE_ROW) {
+        if (sqlite3_column_type(pCur->pStmt, 0) != SQLITE_INTEGER
+            || (bWeight && bfsvtabIsNumber(pCur->pStmt, 1) == 0)) {
+            continue;
+        }
+        iTo = sqlite3_column_int64(pCur->pStmt, 0);
+        if (bWeight) {
+            rWeight = sqlite3_column_double(pCur->pStmt, 1);
+            if (rWeight < 0.0) {
+                sqlite3_reset(pCur->pStmt);
+                goto negativeWeight;
+            }
+        }
+        rc = bfsvtabDijkstraVisit(pCur, iTo, iKey, rCost + rWeight, nHop + 1);
+    }
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_reset(pCur->pStmt);
+    } else {
+        sqlite3_reset(pCur->pStmt);
+    }
+    return rc;
+
+negativeWeight:
+    sqlite3_free(pCur->pVtab->base.zErrMsg);
+    pCur->pVtab->base.zErrMsg = sqlite3_mprintf(
+        "negative weight on an edge from node %lld", bfsvtabNodeId(pCur, iKey));
+    return SQLITE_ERROR;
+}
+
+/*
+** Move to the next row of a weighted traversal: the node with the
+** lightest path among those not yet returned.  Nodes heavier than the
+** distance bound end the traversal, as every later node is heavier still.
+** An A* search takes the node with the lightest path plus estimate, which
+** ends the traversal just as well as long as no estimate is too high.
+** The edges out of the last target are not followed, as nothing beyond
+** it is returned.
+*/
+static int bfsvtabDijkstraNext(bfsvtab_cursor *pCur) {
+    bfsvtab_dijkstra *p = pCur->pDijkstra;
+    bfsvtab_dijkstra_node *pNode;
+    sqlite3_int64 iKey;
+    int bTarget;
+    int rc;
+
+    pCur->pCurrent = 0;
+    while ((pCur->bTargets == 0 || pCur->nTargetLeft > 0)
+           && bfsvtabDijkstraPop(p, &iKey)) {
+        pNode = bfsvtabDijkstraFind(p, iKey);
+        if (pNode->rCost + pNode->rEstimate > pCur->rMaxCost) {
+            break;
+        }
+        pCur->current.id = iKey;
+        pCur->current.parent = pNode->iParent;
+        pCur->current.distance = pNode->nHop;
+        pCur->current.rCost = pNode->rCost;
+        bTarget = bfsvtabIsTarget(pCur, iKey);
+        if (bTarget == 0 || pCur->bTargets == 0 || pCur->nTargetLeft > 1) {
+            rc = bfsvtabDijkstraExpand(pCur, iKey, pNode->rCost, pNode->nHop);
+            if (rc == SQLITE_OK) {
+                rc = bfsvtabCheckMemory(pCur);
+            }
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+        if (bTarget) {
+            pCur->pCurrent = &pCur->current;
+            if (pCur->bTargets) {
+                pCur->nTargetLeft--;
+            }
+            return SQLITE_OK;
+        }
+    }
+    p->nHeap = 0;
+    return SQLITE_OK;
+}
+
+/*
+** Move to the next row of a traversal that uses the queue.  Nodes closer
+** to the root than the minimum depth, and nodes other than the targets
+** when the id column is constrained, are expanded but not returned.  Once
+** every target has been returned the traversal stops.
+*/
+static int bfsvtabTopdownNext(bfsvtab_cursor *pCur) {
+    int rc;
+    do {
+        pCur->pCurrent = 0;
+        if (pCur->bTargets && pCur->nTargetLeft == 0) {
+            queueReset(&pCur->pQueue);
+            pCur->nPending = 0;
+            return SQLITE_OK;
+        }
+        if (queuePull(&pCur->pQueue, &pCur->current.id,
+                      &pCur->current.distance) == 0) {
+            return SQLITE_OK;
+        }
+        pCur->pCurrent = &pCur->current;
+        rc = bfsvtabExpand(pCur);
+        if (rc == SQLITE_OK) {
+            rc = bfsvtabCheckMemory(pCur);
+        }
+    } while (rc == SQLITE_OK
+             && (pCur->pCurrent->distance < pCur->iMinDepth
+                 || !bfsvtabIsTarget(pCur, pCur->pCurrent->id)));
+    if (rc == SQLITE_OK) {
+        /* The parent is only needed for rows that are returned */
+        if (pCur->bParent) {
+            bfsvtabVisitedFind(pCur, pCur->current.id, &pCur->current.parent);
+        }
+        if (pCur->bTargets) {
+            pCur->nTargetLeft--;
+        }
+    }
+    return rc;
+}
+
+/*
+** Recursively builds a node path string.
+*/
+int bfsvtabBuildShortestPathStr(sqlite3_str *str, bfsvtab_cursor *pCur, sqlite3_int64 id) {
+    int rc;
+    sqlite3_int64 parent;
+    if (bfsvtabVisitedFind(pCur, id, &parent) == 0) {
+        return SQLITE_OK;
+    }
+    if (parent != id) {
+        rc = bfsvtabBuildShortestPathStr(str, pCur, parent);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        sqlite3_str_appendf(str, "%lld/", bfsvtabNodeId(pCur, id));
+        rc = sqlite3_str_errcode(str);
+        return rc;
+    }
+    sqlite3_str_appendf(str, "/%lld/", bfsvtabNodeId(pCur, id));
+    rc = sqlite3_str_errcode(str);
+    return rc;
+}
+
+/*
+** Set *pz and *pn to the shortest_path of the current row.  The path is
+** built by appending the row's id to the path of its parent, which is
+** normally still held from when the parent's row was returned.  If not,
+** as when the parent's level was filtered out, the parent's path is built
+** from the visited set and kept for its other children.
+*/
+static int bfsvtabShortestPath(
+    bfsvtab_cursor *pCur,
+    const char **pz,
+    sqlite3_int64 *pn
+) {
+    bfsvtab_node *pNode = pCur->pCurrent;
+    bfsvtab_paths *pLevel = &pCur->aPath[pNode->distance & 1];
+    const char *zPrefix = "/";
+    sqlite3_int64 nPrefix = 1;
+    char zId[24];
+    int rc;
+
+    if (pLevel->iDistance != pNode->distance) {
+        bfsvtabPathsReset(pLevel, pNode->distance);
+    }
+    if (bfsvtabPathsFind(pLevel, pNode->id, pz, pn)) {
+        return SQLITE_OK;
+    }
+    if (pNode->distance > 0) {
+        bfsvtab_paths *pUp = &pCur->aPath[(pNode->distance - 1) & 1];
+        if (pUp->iDistance != pNode->distance - 1) {
+            bfsvtabPathsReset(pUp, pNode->distance - 1);
+        }
+        if (bfsvtabPathsFind(pUp, pNode->parent, &zPrefix, &nPrefix) == 0) {
+            sqlite3_str *s = sqlite3_str_new(pCur->pVtab->db);
+            char *z;
+            rc = bfsvtabBuildShortestPathStr(s, pCur, pNode->parent);
+            if (rc == SQLITE_OK) {
+                rc = sqlite3_str_errcode(s);
+            }
+            z = sqlite3_str_finish(s);
+            if (rc == SQLITE_OK) {
+                rc = bfsvtabPathsAdd(pUp, pNode->parent, 0, 0, z ? z : "",
+                                     &zPrefix, &nPrefix);
+            }
+            sqlite3_free(z);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+    }
+    sqlite3_snprintf(sizeof(zId), zId, "%lld/", bfsvtabNodeId(pCur, pNode->id));
+    return bfsvtabPathsAdd(pLevel, pNode->id, zPrefix, nPrefix, zId, pz, pn);
+}
+
+/*
+** Return values of columns for the row at which the bfsvtab_cursor
+** is currently pointing.
+*/
+static int bfsvtabColumn(
+    sqlite3_vtab_cursor *cur,   /* The cursor */
+    sqlite3_context *ctx,       /* First argument to sqlite3_result_...() */
+    int i                       /* Which column to return */
+) {
+    int rc;
+    const char *z;
+    sqlite3_int64 n;
+    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
+    switch (i) {
+        case BFSVTAB_COL_ID:
+            sqlite3_result_int64(ctx, bfsvtabNodeId(pCur, pCur->pCurrent->id));
+            break;
+        case BFSVTAB_COL_PARENT:
+            if (pCur->pCurrent->parent == pCur->pCurrent->id) {
+                sqlite3_result_null(ctx);
+            } else {
+                sqlite3_result_int64(ctx,
+                        bfsvtabNodeId(pCur, pCur->pCurrent->parent));
+            }
+            break;
+        case BFSVTAB_COL_DISTANCE:
+            if (pCur->pDijkstra) {
+                /* A whole number of weight is reported as an integer */
+                double r = pCur->pCurrent->rCost;
+                if (r < 9.0e18 && (double)(sqlite3_int64)r == r) {
+                    sqlite3_result_int64(ctx, (sqlite3_int64)r);
+                } else {
+                    sqlite3_result_double(ctx, r);
+                }
+            } else {
+                sqlite3_result_int64(ctx, pCur->pCurrent->distance);
+            }
+            break;
+        case BFSVTAB_COL_HOPS:
+            sqlite3_result_int64(ctx, pCur->pCurrent->distance);
+            break;
+        case BFSVTAB_COL_SHORTEST_PATH:
+            rc = bfsvtabShortestPath(pCur, &z, &n);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            sqlite3_result_text64(ctx, z, n, SQLITE_TRANSIENT, SQLITE_UTF8);
+            break;
+        case BFSVTAB_COL_ROOT:
+            sqlite3_result_int64(ctx, bfsvtabRowRoot(pCur));
+            break;
+        case BFSVTAB_COL_TABLENAME:
+            sqlite3_result_text(ctx,
+                    pCur->zTableName ?
+                        pCur->zTableName : pCur->pVtab->zTableName,
+                    -1, SQLITE_TRANSIENT);
+            break;
+        case BFSVTAB_COL_FROMCOLUMN:
+            sqlite3_result_text(ctx,
+                    pCur->zFromColumn ?
+                        pCur->zFromColumn : pCur->pVtab->zFromColumn,
+                    -1, SQLITE_TRANSIENT);
+            break;
+        case BFSVTAB_COL_TOCOLUMN:
+            sqlite3_result_text(ctx,
+                    pCur->zToColumn ?
+                        pCur->zToColumn : pCur->pVtab->zToColumn,
+                    -1, SQLITE_TRANSIENT);
+            break;
+        case BFSVTAB_COL_WEIGHTCOLUMN:
+            sqlite3_result_text(ctx,
+                    pCur->zWeightColumn ?
+                        pCur->zWeightColumn : pCur->pVtab->zWeightColumn,
+                    -1, SQLITE_TRANSIENT);
+            break;
+        case BFSVTAB_COL_HEURISTIC:
+            sqlite3_result_text(ctx,
+                    pCur->zHeuristic ?
+                        pCur->zHeuristic : pCur->pVtab->zHeuristic,
+                    -1, SQLITE_TRANSIENT);
+            break;
+        case BFSVTAB_COL_BATCHSIZE:
+            sqlite3_result_int(ctx, pCur->nBatch);
+            break;
+        case BFSVTAB_COL_ADJACENCY:
+            sqlite3_result_text(ctx, azBfsvtabAdjacency[pCur->eAdjacency],
+                    -1, SQLITE_STATIC);
+            break;
+        case BFSVTAB_COL_ENGINE:
+            sqlite3_result_text(ctx, azBfsvtabEngine[pCur->eEngine],
+                    -1, SQLITE_STATIC);
+            break;
+        case BFSVTAB_COL_THREADS:
+            sqlite3_result_int(ctx, pCur->nThread);
+            break;
+        case BFSVTAB_COL_VISITED:
+            sqlite3_result_text(ctx, azBfsvtabVisited[pCur->eVisited],
+                    -1, SQLITE_STATIC);
+            break;
+        case BFSVTAB_COL_DIRECTION:
+            sqlite3_result_text(ctx, azBfsvtabDirection[pCur->eDirection],
+                    -1, SQLITE_STATIC);
+            break;
+        case BFSVTAB_COL_REFRESH:
+            sqlite3_result_text(ctx, azBfsvtabRefresh[pCur->eRefresh],
+                    -1, SQLITE_STATIC);
+            break;
+        case BFSVTAB_COL_MEMLIMIT:
+            sqlite3_result_int64(ctx, pCur->nMemLimit);
+            break;
+        case BFSVTAB_COL_COMMAND:
+            sqlite3_result_null(ctx);
+            break;
+        default:
+            assert( i==BFSVTAB_COL_SOURCES );
+            sqlite3_result_text(ctx, azBfsvtabSources[pCur->eSources],
+                    -1, SQLITE_STATIC);
+            break;
+    }
+    return SQLITE_OK;
+}
+
+/*
+** Return the rowid for the current row.  In this implementation, the
+** rowid is the same as the output value.
+*/
+static int bfsvtabRowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid) {
+    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
+    *pRowid = bfsvtabNodeId(pCur, pCur->pCurrent->id);
+    return SQLITE_OK;
+}
+
+/*
+** Return TRUE if the cursor has been moved off of the last
+** row of output.
+*/
+static int bfsvtabEof(sqlite3_vtab_cursor *cur) {
+    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
+    return pCur->pCurrent == 0;
+}
+
+/*
+** Read the current data versions of all the databases of the connection,
+** main, temp and attached ones, folded into *piVersion, and the
+** connection's total change count.  Between them these change whenever
+** the content of any database changes, whether through this connection
+** or another one, so an edge table or view in an attached database is
+** covered too.  A data version is only current while a read transaction
+** is open on the database, which the caller ensures for the databases
+** that the edge relation reads.
+**
+** The names of attached databases need sqlite3_db_name(), which is new
+** in SQLite 3.39.  Before that they are read with PRAGMA database_list.
+*/
+static void bfsvtabDataVersion(
+    sqlite3 *db,
+    sqlite3_uint64 *piVersion,
+    int *pnChange
+) {
+    sqlite3_uint64 h = (((sqlite3_uint64)0xcbf29ce4)<<32) | 0x84222325;
+    sqlite3_stmt *pStmt = 0;
+    int i;
+
+    if (sqlite3_libversion_number() < 3039000
+        && sqlite3_prepare_v2(db, "PRAGMA database_list", -1, &pStmt, 0)
+           != SQLITE_OK) {
+        pStmt = 0;
+    }
+    for (i = 0; ; i++) {
+        const char *zDb;
+        unsigned int iVersion = 0;
+        if (sqlite3_libversion_number() >= 3039000) {
+            zDb = sqlite3_db_name(db, i);
+        } else if (pStmt && sqlite3_step(pStmt) == SQLITE_ROW) {
+            zDb = (const char*)sqlite3_column_text(pStmt, 1);
+        } else {
+            zDb = pStmt || i > 1 ? 0 : (i ? "temp" : "main");
+        }
+        if (zDb == 0) {
+            break;
+        }
+        sqlite3_file_control(db, zDb, SQLITE_FCNTL_DATA_VERSION, &iVersion);
+        /* The name is mixed in so that a database attached in place of
+        ** another does not take over its versions */
+        h = (h ^ bfsvtabHashString(zDb)) * ((((sqlite3_uint64)0x100)<<32) | 0x1b3);
+        h = (h ^ iVersion) * ((((sqlite3_uint64)0x100)<<32) | 0x1b3);
+    }
+    sqlite3_finalize(pStmt);
+    *piVersion = h;
+    *pnChange = sqlite3_total_changes(db);
+}
+
+/*
+** Set *ppCsr to an in-memory adjacency for the edge relation zTo(zFrom)
+** of table zTable, with the weights in column zWeight unless that is
+** NULL and with every edge also loaded backwards if bBoth is true,
+** holding a reference that the caller must release with bfsvtabCsrUnref().
+** If an error is returned, its message is left in pVtab->base.zErrMsg.
+**
+** The adjacency is taken from the cache on pVtab if an entry for the
+** same relation exists and the database has not changed since it was
+** built.  Otherwise it is built from scratch and, if no transaction is
+** open, added to the cache.  While a transaction is open the connection
+** may hold uncommitted changes that a later ROLLBACK would discard, so
+** an adjacency built then is not kept, and an entry that is out of date
+** is left as it was.
+**
+** If bIncremental is true, or the entry already has a log, the changes
+** this connection makes to the edge table are logged, and an entry that
+** only they made out of date is brought up to date by applying them.
+**
+** If bStored is true and no transaction is open, an adjacency that is not
+** in the cache or out of date is loaded from the shadow tables of pVtab
+** when they hold an up to date one for the same relation.  Nothing is
+** saved there, which only the rebuild command does.
+**
+** If bMapped is true and no transaction is open, an adjacency that is not
+** in the cache is mapped from the file of the relation when it is up to
+** date, and one that is built is written there (see bfsvtabMapLoad()).
+**
+** If bShared is true and no transaction is open, an adjacency that is
+** not in the cache or out of date is taken from the cache shared by the
+** connections of the process when it holds one for the current content
+** of the database, and one that is built is put there (see "Shared
+** adjacency").
+*/
+static int bfsvtabCsrAcquire(
+    bfsvtab_vtab *pVtab,
+    const char *zTable,
+    const char *zFrom,
+    const char *zTo,
+    const char *zWeight,
+    int bBoth,
+    int bStored,
+    int bIncremental,
+    int bMapped,
+    int bShared,
+    bfsvtab_csr **ppCsr
+) {
+    bfsvtab_cache **pp;
+    bfsvtab_cache *p;
+    bfsvtab_csr *pPrivate = 0;      /* Adjacency not kept in the cache */
+    sqlite3_uint64 iVersion;
+    int nChange;
+    int bAutocommit;
+    int bStale;
+    int bTransient = 0;             /* True if p is dropped after use */
+    int nEntry = 0;
+    int rc = SQLITE_OK;
+
+    *ppCsr = 0;
+    for (pp = &pVtab->pCache; (p = *pp) != 0; pp = &p->pNext) {
+        if (strcmp(p->zTableName, zTable) == 0
+            && strcmp(p->zFromColumn, zFrom) == 0
+            && strcmp(p->zToColumn, zTo) == 0
+            && strcmp(p->zWeightColumn, zWeight ? zWeight : "") == 0
+            && p->bBoth == bBoth) {
+            *pp = p->pNext;
+            break;
+        }
+    }
+    if (p == 0) {
+        char *zSql;
+        p = sqlite3_malloc(sizeof(*p));
+        if (p == 0) {
+            return SQLITE_NOMEM;
+        }
+        memset(p, 0, sizeof(*p));
+        p->zTableName = sqlite3_mprintf("%s", zTable);
+        p->zFromColumn = sqlite3_mprintf("%s", zFrom);
+        p->zToColumn = sqlite3_mprintf("%s", zTo);
+        p->zWeightColumn = sqlite3_mprintf("%s", zWeight ? zWeight : "");
+        p->bBoth = bBoth;
+        zSql = sqlite3_mprintf("SELECT (SELECT 1 FROM \"%w\" LIMIT 1)", zTable);
+        if (p->zTableName == 0 || p->zFromColumn == 0
+            || p->zToColumn == 0 || p->zWeightColumn == 0 || zSql == 0) {
+            sqlite3_free(zSql);
+            bfsvtabCacheFree(p);
+            return SQLITE_NOMEM;
+        }
+        rc = sqlite3_prepare_v2(pVtab->db, zSql, -1, &p->pProbe, 0);
+        sqlite3_free(zSql);
+        if (rc != SQLITE_OK) {
+            sqlite3_free(pVtab->base.zErrMsg);
+            pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+            bfsvtabCacheFree(p);
+            return rc;
+        }
+    }
+
+    /* The probe statement reads the edge table, so while it is active a
+    ** read transaction is open on the database that holds it.  That makes
+    ** the data versions current and keeps them current while the
+    ** adjacency is rebuilt.  */
+    if (sqlite3_step(p->pProbe) != SQLITE_ROW) {
+        rc = sqlite3_reset(p->pProbe);
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+        bfsvtabCacheFree(p);
+        return rc != SQLITE_OK ? rc : SQLITE_ERROR;
+    }
+    bfsvtabDataVersion(pVtab->db, &iVersion, &nChange);
+    bAutocommit = sqlite3_get_autocommit(pVtab->db) != 0;
+    if (bAutocommit == 0) {
+        bStored = 0;
+        bMapped = 0;
+        bShared = 0;
+    }
+    if (p->pCsr == 0 && bMapped) {
+        rc = bfsvtabMapLoad(pVtab, p, &p->pCsr);
+        if (p->pCsr) {
+            p->iVersion = iVersion;
+            p->nChange = nChange;
+            p->bMapped = 1;
+        }
+    }
+    bStale = p->pCsr == 0
+          || p->iVersion != iVersion
+          || p->nChange != nChange;
+    if (rc == SQLITE_OK && bStale && bStored) {
+        bfsvtab_csr *pCsr = 0;
+        rc = bfsvtabStoredLoad(pVtab, zTable, zFrom, zTo, zWeight, bBoth,
+                               &pCsr);
+        if (pCsr) {
+            bfsvtabCsrUnref(p->pCsr);
+            p->pCsr = pCsr;
+            p->iVersion = iVersion;
+            p->nChange = nChange;
+            p->bMapped = 0;
+            p->bShared = 0;
+            bStale = 0;
+            if (rc == SQLITE_OK && (bIncremental || p->zLog)) {
+                /* The log is only valid for the adjacency it was kept for */
+                rc = bfsvtabLogInstall(pVtab, p);
+                bfsvtabDataVersion(pVtab->db, &p->iVersion, &p->nChange);
+            }
+        }
+    }
+    if (rc == SQLITE_OK && bStale && bShared) {
+        bfsvtab_csr *pCsr = 0;
+        rc = bfsvtabSharedGet(pVtab, p, &pCsr);
+        if (pCsr) {
+            bfsvtabCsrUnref(p->pCsr);
+            p->pCsr = pCsr;
+            p->iVersion = iVersion;
+            p->nChange = nChange;
+            p->bMapped = 0;
+            p->bShared = 1;
+            bStale = 0;
+            if (rc == SQLITE_OK && (bIncremental || p->zLog)) {
+                /* The log is only valid for the adjacency it was kept for */
+                rc = bfsvtabLogInstall(pVtab, p);
+                bfsvtabDataVersion(pVtab->db, &p->iVersion, &p->nChange);
+            }
+        }
+    }
+    if (rc == SQLITE_OK && bStale && p->pCsr && p->zLog) {
+        sqlite3_int64 iForeign = 0;
+        int bApplied = 0;
+        rc = bfsvtabForeignVersion(pVtab->db, &iForeign);
+        if (rc == SQLITE_OK && iForeign == p->iForeign) {
+            /* Only this connection has committed changes, and the log
+            ** holds all of those made to the edge table */
+            rc = bfsvtabLogApply(pVtab, p, bAutocommit ? 0 : &pPrivate,
+                                 &bApplied);
+            if (bApplied) {
+                bStale = 0;
+                if (bAutocommit) {
+                    bfsvtabDataVersion(pVtab->db, &p->iVersion, &p->nChange);
+                }
+            }
+        }
+        if (rc != SQLITE_OK && rc != SQLITE_NOMEM) {
+            bfsvtabLogDrop(pVtab->db, p);
+            rc = SQLITE_OK;
+        }
+    }
+    if (rc == SQLITE_OK && bStale) {
+        if (bAutocommit == 0 && p->pCsr) {
+            rc = bfsvtabCsrBuild(pVtab->db, zTable, zFrom, zTo, zWeight, bBoth,
+                                 &pPrivate);
+        } else {
+            bfsvtabCsrUnref(p->pCsr);
+            p->pCsr = 0;
+            rc = bfsvtabCsrBuild(pVtab->db, zTable, zFrom, zTo, zWeight, bBoth,
+                                 &p->pCsr);
+            p->iVersion = iVersion;
+            p->nChange = nChange;
+            p->bMapped = 0;
+            p->bShared = 0;
+            bTransient = bAutocommit == 0;
+            if (rc == SQLITE_OK && bAutocommit && (bIncremental || p->zLog)) {
+                rc = bfsvtabLogInstall(pVtab, p);
+                bfsvtabDataVersion(pVtab->db, &p->iVersion, &p->nChange);
+            }
+        }
+    }
+    if (rc == SQLITE_OK && bMapped && p->bMapped == 0) {
+        /* Written while the probe keeps the read transaction open, so
+        ** that the file change counter still matches the adjacency.  Not
+        ** tried again until the adjacency changes. */
+        rc = bfsvtabMapSave(pVtab, p);
+        p->bMapped = 1;
+    }
+    if (rc == SQLITE_OK && bShared && p->bShared == 0) {
+        /* Not tried again until the adjacency changes */
+        rc = bfsvtabSharedPut(pVtab, p);
+        p->bShared = 1;
+    }
+    if (rc != SQLITE_OK) {
+        /* Taken before the reset, which clears the error of the connection */
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+    }
+    sqlite3_reset(p->pProbe);
+    if (rc != SQLITE_OK) {
+        bfsvtabCsrUnref(pPrivate);
+        bfsvtabCacheFree(p);
+        return rc;
+    }
+    if (pPrivate) {
+        *ppCsr = pPrivate;
+    } else {
+        bfsvtabCsrRef(p->pCsr);
+        *ppCsr = p->pCsr;
+    }
+    if (bTransient) {
+        bfsvtabCacheFree(p);
+        return SQLITE_OK;
+    }
+    p->pNext = pVtab->pCache;
+    pVtab->pCache = p;
+
+    /* Drop the least recently used entries beyond BFSVTAB_MAX_CACHE */
+    for (p = pVtab->pCache; p; p = p->pNext) {
+        if (++nEntry == BFSVTAB_MAX_CACHE) {
+            while (p->pNext) {
+                bfsvtab_cache *pNext = p->pNext->pNext;
+                bfsvtabLogDrop(pVtab->db, p->pNext);
+                bfsvtabCacheFree(p->pNext);
+                p->pNext = pNext;
+            }
+            break;
+        }
+    }
+    return SQLITE_OK;
+}
+
+/*
+** Set the depth bounds of the traversal from the value of the distance
+** term found by xBestIndex (see the idxNum bits there).  Only numeric
+** values are used, as comparisons with other types do not translate into
+** a bound.  The term is still checked by SQLite, so the bounds only need
+** to be conservative for non-integer values.
+**
+** In a weighted traversal the distance is the weight of the path, and
+** the term only bounds that weight.
+*/
+static void bfsvtabSetDepth(
+    bfsvtab_cursor *pCur,
+    int idxNum,
+    sqlite3_value *pDistance
+) {
+    sqlite3_int64 iBound;
+    double rBound;
+
+    pCur->iMinDepth = 0;
+    pCur->iMaxDepth = LARGEST_INT64;
+    pCur->rMaxCost = DBL_MAX;
+    if (pDistance == 0) {
+        return;
+    }
+    if (pCur->pDijkstra) {
+        switch (sqlite3_value_type(pDistance)) {
+            case SQLITE_NULL:
+                pCur->iMaxDepth = -1;
+                break;
+            case SQLITE_INTEGER:
+            case SQLITE_FLOAT:
+                pCur->rMaxCost = sqlite3_value_double(pDistance);
+                if (pCur->rMaxCost < 0.0) {
+                    pCur->iMaxDepth = -1;
+                }
+                break;
         }
-        zVal = bfsvtabValueOfKey("tocolumn", argv[i]);
-        if (zVal) {
-            sqlite3_free(pNew->zToColumn);
-            pNew->zToColumn = bfsvtabDequote(zVal);
-            if (pNew->zToColumn == 0) {
-                rc = SQLITE_NOMEM;
-                goto connectError;
+        return;
+    }
+    switch (sqlite3_value_type(pDistance)) {
+        case SQLITE_NULL:
+            /* A comparison with NULL is never true */
+            pCur->iMaxDepth = -1;
+            return;
+        case SQLITE_INTEGER:
+            iBound = sqlite3_value_int64(pDistance);
+            if ((idxNum & 0x02) != 0) {
+                if (iBound <= 0) {
+                    pCur->iMaxDepth = -1;
+                    return;
+                }
+                iBound--;
+            }
+            break;
+        case SQLITE_FLOAT:
+            rBound = sqlite3_value_double(pDistance);
+            if (rBound < 0.0) {
+                pCur->iMaxDepth = -1;
+                return;
+            }
+            if (rBound >= 9.0e18) {
+                return;
+            }
+            /* Largest integer not greater than (or, for "<", less than)
+            ** rBound */
+            iBound = (sqlite3_int64)rBound;
+            if ((idxNum & 0x02) != 0 && (double)iBound == rBound) {
+                iBound--;
+            }
+            break;
+        default:
+            return;
+    }
+    pCur->iMaxDepth = iBound;
+    if ((idxNum & 0x08) != 0) {
+        pCur->iMinDepth = iBound;
+    }
+}
+
+/*
+** Add the node whose id is the value pVal to the set of target nodes.
+** Values that cannot equal an integer id are ignored, as are ids that do
+** not occur in the in-memory adjacency (other than the root).
+*/
+static int bfsvtabAddTarget(bfsvtab_cursor *pCur, sqlite3_value *pVal) {
+    sqlite3_int64 id;
+    sqlite3_int64 iKey;
+    double r;
+    int bNew;
+    int rc;
+
+    switch (sqlite3_value_type(pVal)) {
+        case SQLITE_INTEGER:
+            id = sqlite3_value_int64(pVal);
+            break;
+        case SQLITE_FLOAT:
+            r = sqlite3_value_double(pVal);
+            if (r < -9.0e18 || r > 9.0e18) {
+                return SQLITE_OK;
+            }
+            id = (sqlite3_int64)r;
+            if ((double)id != r) {
+                return SQLITE_OK;
+            }
+            break;
+        default:
+            return SQLITE_OK;
+    }
+    iKey = id;
+    if (pCur->pCsr) {
+        bfsvtab_hash_entry *pEntry = bfsvtabHashSearch(&pCur->pCsr->index, id);
+        if (pEntry) {
+            iKey = pEntry->value;
+        } else {
+            sqlite3_int64 i;
+            for (i = 0; i < pCur->roots.n && pCur->roots.a[i] != id; i++);
+            if (i == pCur->roots.n) {
+                return SQLITE_OK;
             }
+            iKey = pCur->pCsr->nNode + i;
+        }
+    }
+    rc = bfsvtabHashInsert(&pCur->targets, iKey, 0, &bNew);
+    if (rc == SQLITE_OK && bNew) {
+        pCur->nTarget++;
+        pCur->iTarget = iKey;
+    }
+    return rc;
+}
+
+/*
+** Set the roots to the value of a root = ? term, or to the values of a
+** root IN (...) term if bIn is true.  NULL values of an IN list match no
+** row and are skipped, as are repeated values.
+*/
+static int bfsvtabSetRoots(bfsvtab_cursor *pCur, int bIn, sqlite3_value *pRoot) {
+    bfsvtab_hash seen;
+    sqlite3_value *pVal;
+    int bNew;
+    int rc;
+
+    if (bIn == 0) {
+        return bfsvtabKeysAppend(&pCur->roots, sqlite3_value_int64(pRoot));
+    }
+    memset(&seen, 0, sizeof(seen));
+    for (rc = sqlite3_vtab_in_first(pRoot, &pVal);
+         rc == SQLITE_OK && pVal;
+         rc = sqlite3_vtab_in_next(pRoot, &pVal)) {
+        sqlite3_int64 id;
+        if (sqlite3_value_type(pVal) == SQLITE_NULL) {
             continue;
         }
-        *pzErr = sqlite3_mprintf("unrecognized argument: [%s]\n", argv[i]);
-        bfsvtabFree(pNew);
-        return SQLITE_ERROR;
+        id = sqlite3_value_int64(pVal);
+        rc = bfsvtabHashInsert(&seen, id, 0, &bNew);
+        if (rc == SQLITE_OK && bNew) {
+            rc = bfsvtabKeysAppend(&pCur->roots, id);
+        }
+        if (rc != SQLITE_OK) {
+            break;
+        }
     }
+    bfsvtabHashClear(&seen);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
 
-    rc = sqlite3_declare_vtab(db,
-       "CREATE TABLE x(id,parent,distance,shortest_path,root HIDDEN,"
-                       "tablename HIDDEN,fromcolumn HIDDEN,"
-                       "tocolumn HIDDEN)"
-    );
-    /* For convenience, define symbolic names for the index to each column. */
-#define BFSVTAB_COL_ID              0
-#define BFSVTAB_COL_PARENT          1
-#define BFSVTAB_COL_DISTANCE        2
-#define BFSVTAB_COL_SHORTEST_PATH   3
-#define BFSVTAB_COL_ROOT            4
-#define BFSVTAB_COL_TABLENAME       5
-#define BFSVTAB_COL_FROMCOLUMN      6
-#define BFSVTAB_COL_TOCOLUMN        7
-    if (rc != SQLITE_OK) {
-        bfsvtabFree(pNew);
+/*
+** Set up the set of target nodes from the value of the id term found
+** by xBestIndex.  If bIn is true, the term is an IN operator whose
+** right-hand side values are all passed at once.
+*/
+static int bfsvtabSetTargets(bfsvtab_cursor *pCur, int bIn, sqlite3_value *pId) {
+    int rc = SQLITE_OK;
+    pCur->bTargets = 1;
+    if (bIn) {
+        sqlite3_value *pVal;
+        for (rc = sqlite3_vtab_in_first(pId, &pVal);
+             rc == SQLITE_OK && pVal;
+             rc = sqlite3_vtab_in_next(pId, &pVal)) {
+            rc = bfsvtabAddTarget(pCur, pVal);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+        if (rc == SQLITE_DONE) {
+            rc = SQLITE_OK;
+        }
+    } else {
+        rc = bfsvtabAddTarget(pCur, pId);
     }
-    *ppVtab = (sqlite3_vtab*)pNew;
+    pCur->nTargetLeft = pCur->nTarget;
     return rc;
+}
 
-connectError:
-    bfsvtabFree(pNew);
+/*
+** Append the keys of the neighbours of the node with key iKey to pOut.
+** If bReverse is true, edges are followed backwards, so the neighbours
+** are the nodes that have an edge to iKey.
+*/
+static int bfsvtabFetch(
+    bfsvtab_cursor *pCur,
+    int bReverse,
+    sqlite3_int64 iKey,
+    bfsvtab_keys *pOut
+) {
+    sqlite3_stmt *pStmt;
+    int iCol;
+    int rc;
+
+    if (pCur->pCsr) {
+        bfsvtab_csr *pCsr = pCur->pCsr;
+        sqlite3_int64 i;
+        if (iKey >= pCsr->nNode) {
+            return SQLITE_OK;
+        }
+        if (bReverse) {
+            for (i = pCsr->aRevOffset[iKey]; i < pCsr->aRevOffset[iKey + 1]; i++) {
+                rc = bfsvtabKeysAppend(pOut, pCsr->aRevSource[i]);
+                if (rc != SQLITE_OK) {
+                    return rc;
+                }
+            }
+        } else {
+            for (i = pCsr->aOffset[iKey]; i < pCsr->aOffset[iKey + 1]; i++) {
+                rc = bfsvtabKeysAppend(pOut, pCsr->aTarget[i]);
+                if (rc != SQLITE_OK) {
+                    return rc;
+                }
+            }
+        }
+        return SQLITE_OK;
+    }
+
+    /* The batched statement returns (from, to) pairs, and any of its
+    ** parameters other than ?1 are left NULL here. */
+    pStmt = bReverse ? pCur->pRevStmt : pCur->pStmt;
+    iCol = (bReverse == 0 && pCur->nBatch > 1) ? 1 : 0;
+    rc = sqlite3_bind_int64(pStmt, 1, iKey);
+    while (rc == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW) {
+        if (sqlite3_column_type(pStmt, iCol) == SQLITE_INTEGER) {
+            rc = bfsvtabKeysAppend(pOut, sqlite3_column_int64(pStmt, iCol));
+        }
+    }
+    if (rc != SQLITE_OK) {
+        sqlite3_reset(pStmt);
+        return rc;
+    }
+    sqlite3_clear_bindings(pStmt);
+    return sqlite3_reset(pStmt);
+}
+
+/*
+** Search from the root and the target at the same time, always
+** expanding a whole level of whichever side has the smaller frontier,
+** until the two searches meet.  This finds the length of a shortest path
+** while usually reaching far fewer nodes than a search from the root
+** alone.
+**
+** The nodes that lie on some shortest path are then collected into
+** pCur->onPath, working outwards from the layer where the searches met.
+** The ordinary traversal from the root, limited to those nodes, finds
+** the target with exactly the parent (and so the shortest_path) that the
+** unrestricted traversal would have found.  If there is no path, or none
+** short enough, pCur->onPath is left empty.
+*/
+static int bfsvtabBidirectional(
+    bfsvtab_cursor *pCur,
+    sqlite3_int64 iRoot,
+    sqlite3_int64 iTarget
+) {
+    bfsvtab_hash aDist[2];      /* Distance from the root, and to the target */
+    bfsvtab_keys aLevel[2];     /* Frontier of each search */
+    sqlite3_int64 aRadius[2];   /* Distance of each frontier */
+    bfsvtab_keys next;          /* Next level of the search being expanded */
+    bfsvtab_keys nbr;           /* Neighbours of a single node */
+    bfsvtab_keys layer;         /* Nodes on shortest paths at one distance */
+    bfsvtab_keys tmp;
+    bfsvtab_hash_entry *pEntry;
+    sqlite3_int64 nPath = -1;   /* Length of a shortest path */
+    sqlite3_int64 i, j, k;
+    int iSide;
+    int bNew;
+    int rc;
+
+    memset(aDist, 0, sizeof(aDist));
+    memset(aLevel, 0, sizeof(aLevel));
+    memset(&next, 0, sizeof(next));
+    memset(&nbr, 0, sizeof(nbr));
+    memset(&layer, 0, sizeof(layer));
+    aRadius[0] = aRadius[1] = 0;
+    pCur->bOnPath = 1;
+
+    if (pCur->pCsr) {
+        rc = bfsvtabCsrReverse(pCur->pCsr);
+        if (rc != SQLITE_OK) {
+            goto bidirectionalEnd;
+        }
+    }
+    rc = bfsvtabHashInsert(&aDist[0], iRoot, 0, &bNew);
+    if (rc == SQLITE_OK) rc = bfsvtabHashInsert(&aDist[1], iTarget, 0, &bNew);
+    if (rc == SQLITE_OK) rc = bfsvtabKeysAppend(&aLevel[0], iRoot);
+    if (rc == SQLITE_OK) rc = bfsvtabKeysAppend(&aLevel[1], iTarget);
+    if (rc != SQLITE_OK) {
+        goto bidirectionalEnd;
+    }
+
+    /* Find the length of a shortest path.  Every node within aRadius[i]
+    ** of the root (or target) is in aDist[i], so the first level on which
+    ** the searches meet gives the length. */
+    while (nPath < 0) {
+        if (aLevel[0].n == 0 || aLevel[1].n == 0
+            || aRadius[0] + aRadius[1] >= pCur->iMaxDepth) {
+            goto bidirectionalEnd;
+        }
+        iSide = aLevel[1].n < aLevel[0].n;
+        next.n = 0;
+        for (i = 0; i < aLevel[iSide].n; i++) {
+            nbr.n = 0;
+            rc = bfsvtabFetch(pCur, iSide, aLevel[iSide].a[i], &nbr);
+            for (j = 0; rc == SQLITE_OK && j < nbr.n; j++) {
+                rc = bfsvtabHashInsert(&aDist[iSide], nbr.a[j], aRadius[iSide] + 1, &bNew);
+                if (rc != SQLITE_OK || bNew == 0) {
+                    continue;
+                }
+                rc = bfsvtabKeysAppend(&next, nbr.a[j]);
+                pEntry = bfsvtabHashSearch(&aDist[!iSide], nbr.a[j]);
+                if (pEntry && (nPath < 0 || aRadius[iSide] + 1 + pEntry->value < nPath)) {
+                    nPath = aRadius[iSide] + 1 + pEntry->value;
+                }
+            }
+            if (rc != SQLITE_OK) {
+                goto bidirectionalEnd;
+            }
+        }
+        tmp = aLevel[iSide];
+        aLevel[iSide] = next;
+        next = tmp;
+        aRadius[iSide]++;
+    }
+    if (nPath > pCur->iMaxDepth) {
+        goto bidirectionalEnd;
+    }
+
+    /* The nodes of the forward frontier that are nPath-aRadius[0] from the
+    ** target are exactly the nodes at that distance along shortest paths.
+    ** Work back towards the root from them, and on towards the target,
+    ** keeping only the neighbours that are one step closer to the end. */
+    next.n = 0;
+    for (i = 0; i < aLevel[0].n; i++) {
+        pEntry = bfsvtabHashSearch(&aDist[1], aLevel[0].a[i]);
+        if (pEntry && pEntry->value == nPath - aRadius[0]) {
+            rc = bfsvtabHashInsert(&pCur->onPath, aLevel[0].a[i], 0, &bNew);
+            if (rc == SQLITE_OK) rc = bfsvtabKeysAppend(&next, aLevel[0].a[i]);
+            if (rc != SQLITE_OK) {
+                goto bidirectionalEnd;
+            }
+        }
+    }
+    for (iSide = 0; iSide < 2; iSide++) {
+        /* Step towards the root (iSide==0) or the target (iSide==1) */
+        layer.n = 0;
+        for (i = 0; rc == SQLITE_OK && i < next.n; i++) {
+            rc = bfsvtabKeysAppend(&layer, next.a[i]);
+        }
+        for (k = aRadius[0]; rc == SQLITE_OK && (iSide ? k < nPath : k > 0); k += iSide ? 1 : -1) {
+            sqlite3_int64 iWant = iSide ? nPath - k - 1 : k - 1;
+            tmp = layer;
+            memset(&layer, 0, sizeof(layer));
+            for (i = 0; rc == SQLITE_OK && i < tmp.n; i++) {
+                nbr.n = 0;
+                rc = bfsvtabFetch(pCur, !iSide, tmp.a[i], &nbr);
+                for (j = 0; rc == SQLITE_OK && j < nbr.n; j++) {
+                    pEntry = bfsvtabHashSearch(&aDist[iSide], nbr.a[j]);
+                    if (pEntry == 0 || pEntry->value != iWant) {
+                        continue;
+                    }
+                    rc = bfsvtabHashInsert(&pCur->onPath, nbr.a[j], 0, &bNew);
+                    if (rc == SQLITE_OK && bNew) {
+                        rc = bfsvtabKeysAppend(&layer, nbr.a[j]);
+                    }
+                }
+            }
+            bfsvtabKeysClear(&tmp);
+        }
+    }
+
+bidirectionalEnd:
+    bfsvtabHashClear(&aDist[0]);
+    bfsvtabHashClear(&aDist[1]);
+    bfsvtabKeysClear(&aLevel[0]);
+    bfsvtabKeysClear(&aLevel[1]);
+    bfsvtabKeysClear(&next);
+    bfsvtabKeysClear(&nbr);
+    bfsvtabKeysClear(&layer);
     return rc;
 }
 
 /*
-** This method is the destructor for bfsvtab_vtab objects.
+** Begin a traversal at the nKey distinct nodes in aKey[], all at distance
+** zero.  The cursor is left before the first row.
 */
-static int bfsvtabDisconnect(sqlite3_vtab *pVtab) {
-    bfsvtab_vtab *p = (bfsvtab_vtab*)pVtab;
-    bfsvtabFree(p);
+static int bfsvtabStart(
+    bfsvtab_cursor *pCur,
+    const sqlite3_int64 *aKey,
+    sqlite3_int64 nKey
+) {
+    sqlite3_int64 i;
+    int rc;
+    int bNew;
+
+    if (pCur->pDijkstra) {
+        /* A node is only final once it is returned, so targets are not
+        ** counted as they are reached */
+        for (i = 0; i < nKey; i++) {
+            rc = bfsvtabDijkstraVisit(pCur, aKey[i], aKey[i], 0.0, 0);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+        return SQLITE_OK;
+    }
+    if (pCur->eEngine == BFSVTAB_ENGINE_MSBFS) {
+        /* Parents are found by following edges backwards */
+        rc = SQLITE_OK;
+        if (pCur->bParent) {
+            rc = bfsvtabCsrReverse(pCur->pCsr);
+        }
+        if (rc == SQLITE_OK) {
+            rc = bfsvtabMsbfsNew(pCur->pCsr->nNode + pCur->roots.n,
+                                 aKey, nKey, &pCur->pMsbfs);
+        }
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        for (i = 0; pCur->bTargets && i < nKey; i++) {
+            if (bfsvtabIsTarget(pCur, aKey[i])) {
+                pCur->nTargetSeen++;
+            }
+        }
+        return SQLITE_OK;
+    }
+    if (pCur->eEngine == BFSVTAB_ENGINE_DIROPT) {
+        /* The roots are the first level */
+        rc = bfsvtabCsrReverse(pCur->pCsr);
+        if (rc == SQLITE_OK) {
+            rc = bfsvtabDiroptNew(pCur->pCsr, pCur->pCsr->nNode + pCur->roots.n,
+                                  aKey, nKey, pCur->nThread, pCur->bParent,
+                                  &pCur->pDiropt);
+        }
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        for (i = 0; pCur->bTargets && i < nKey; i++) {
+            if (bfsvtabIsTarget(pCur, aKey[i])) {
+                pCur->nTargetSeen++;
+            }
+        }
+        return SQLITE_OK;
+    }
+    for (i = 0; i < nKey; i++) {
+        rc = queuePush(&pCur->pQueue, aKey[i]);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        rc = bfsvtabVisitedAdd(pCur, aKey[i], aKey[i], &bNew);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        if (pCur->bTargets && bfsvtabIsTarget(pCur, aKey[i])) {
+            pCur->nTargetSeen++;
+        }
+    }
     return SQLITE_OK;
 }
 
 /*
-** Constructor for a new bfsvtab_cursor object.
+** Return the key of the i-th root.  With the in-memory adjacency, a root
+** that has no edges is given a key of its own past the last node.
 */
-static int bfsvtabOpen(sqlite3_vtab *p, sqlite3_vtab_cursor **ppCursor) {
-    bfsvtab_vtab *pVtab = (bfsvtab_vtab*)p;
-    bfsvtab_cursor *pCur;
-    pCur = sqlite3_malloc(sizeof(*pCur));
-    if (pCur == 0) {
-        return SQLITE_NOMEM;
+static sqlite3_int64 bfsvtabRootKey(bfsvtab_cursor *pCur, sqlite3_int64 i) {
+    bfsvtab_hash_entry *pEntry;
+    if (pCur->pCsr == 0) {
+        return pCur->roots.a[i];
     }
-    memset(pCur, 0, sizeof(*pCur));
-    pCur->pVtab = pVtab;
-    *ppCursor = &pCur->base;
-    return SQLITE_OK;
+    pEntry = bfsvtabHashSearch(&pCur->pCsr->index, pCur->roots.a[i]);
+    return pEntry ? pEntry->value : pCur->pCsr->nNode + i;
 }
 
-static void bfsvtabClearCursor(bfsvtab_cursor *pCur) {
-  bfsvtabAvlDestroy(pCur->pVisited, (void(*)(bfsvtab_avl*))sqlite3_free);
-  queueDestroy(&pCur->pQueue, (void(*)(bfsvtab_node*))sqlite3_free);
-  memset(&pCur->pQueue, 0, sizeof(pCur->pQueue));
+/*
+** Begin the traversal from the next root, or from all of the roots when
+** they are searched together.  The state of any previous traversal is
+** reset first.
+*/
+static int bfsvtabBegin(bfsvtab_cursor *pCur) {
+    bfsvtab_vtab *pVtab = pCur->pVtab;
+    bfsvtab_keys seeds;
+    sqlite3_int64 iKey;
+    int rc = SQLITE_OK;
 
-  sqlite3_free(pCur->zTableName);
-  sqlite3_free(pCur->zFromColumn);
-  sqlite3_free(pCur->zToColumn);
+    if (pCur->iRoot > 0) {
+        bfsvtabVisitedReset(pCur);
+        queueReset(&pCur->pQueue);
+        pCur->nPending = 0;
+        bfsvtabDiroptFree(pCur->pDiropt);
+        pCur->pDiropt = 0;
+        bfsvtabMsbfsFree(pCur->pMsbfs);
+        pCur->pMsbfs = 0;
+        if (pCur->pDijkstra) {
+            bfsvtabDijkstraReset(pCur->pDijkstra);
+        }
+        pCur->aPath[0].iDistance = -1;
+        pCur->aPath[1].iDistance = -1;
+        pCur->nTargetSeen = 0;
+        pCur->nTargetLeft = pCur->nTarget;
+        bfsvtabHashReset(&pCur->onPath);
+        pCur->bOnPath = 0;
+    }
+    pCur->root = pCur->roots.a[pCur->iRoot];
 
-  sqlite3_finalize(pCur->pStmt);
+    memset(&seeds, 0, sizeof(seeds));
+    do {
+        rc = bfsvtabKeysAppend(&seeds, bfsvtabRootKey(pCur, pCur->iRoot++));
+    } while (rc == SQLITE_OK && pCur->iRoot < pCur->roots.n
+             && (pCur->eSources == BFSVTAB_SOURCES_NEAREST
+                 || (pCur->eEngine == BFSVTAB_ENGINE_MSBFS
+                     && seeds.n < BFSVTAB_MSBFS_WIDTH)));
+    if (rc != SQLITE_OK) {
+        bfsvtabKeysClear(&seeds);
+        return rc;
+    }
 
-  pCur->zTableName = 0;
-  pCur->zFromColumn = 0;
-  pCur->zToColumn = 0;
-  pCur->pCurrent = 0;
-  pCur->pVisited = 0;
+    iKey = seeds.a[0];
+    if (seeds.n == 1 && pCur->nTarget == 1 && pCur->iTarget != iKey
+        && pCur->eEngine == BFSVTAB_ENGINE_TOPDOWN && pCur->pDijkstra == 0
+        && (pCur->pCsr || pCur->pRevStmt)) {
+        /* A single target: find the nodes on its shortest paths first */
+        rc = bfsvtabBidirectional(pCur, iKey, pCur->iTarget);
+        if (rc != SQLITE_OK) {
+            sqlite3_free(pVtab->base.zErrMsg);
+            pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+        }
+    }
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabStart(pCur, seeds.a, seeds.n);
+    }
+    if (rc == SQLITE_OK && pCur->pMsbfs) {
+        /* Each target is looked for once per root of the batch */
+        pCur->pMsbfs->iBase = pCur->iRoot - seeds.n;
+        pCur->pMsbfs->nPair = pCur->nTarget * seeds.n;
+        pCur->nTargetLeft = pCur->pMsbfs->nPair;
+    }
+    bfsvtabKeysClear(&seeds);
+    return rc;
 }
 
 /*
-** Destructor for a bfsvtab_cursor.
+** Advance a bfsvtab_cursor to its next row of output.  Once a traversal
+** runs out of rows, the traversal from the next root begins.
+**
+** With a memlimit, the memory held by the traversal is checked after each
+** node is expanded, or each level is found, whether or not it makes a row,
+** and again here for the paths built for the row.  Structures grow by
+** doubling, so a step can overshoot the limit by up to the size of the
+** largest of them.
 */
-static int bfsvtabClose(sqlite3_vtab_cursor *cur) {
+static int bfsvtabNext(sqlite3_vtab_cursor *cur) {
     bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
-    bfsvtabClearCursor(pCur);
-    sqlite3_free(pCur);
+    int rc = SQLITE_OK;
+    for (;;) {
+        if (pCur->pDiropt) {
+            rc = bfsvtabDiroptNext(pCur);
+        } else if (pCur->pMsbfs) {
+            rc = bfsvtabMsbfsNext(pCur);
+        } else if (pCur->pDijkstra) {
+            rc = pCur->iRoot > 0 ? bfsvtabDijkstraNext(pCur) : SQLITE_OK;
+        } else if (pCur->iRoot > 0) {
+            rc = bfsvtabTopdownNext(pCur);
+        }
+        if (rc != SQLITE_OK || pCur->pCurrent || pCur->iRoot >= pCur->roots.n) {
+            break;
+        }
+        rc = bfsvtabBegin(pCur);
+        if (rc != SQLITE_OK) {
+            break;
+        }
+    }
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabCheckMemory(pCur);
+    }
+    return rc;
+}
+
+/*
+** Prepare the statement used to look up the neighbours of a node (or of
+** a batch of nodes) in the edge table.  A weighted traversal looks up one
+** node at a time, along with the weight of each edge.  When edges are
+** followed both ways, the statement is a UNION ALL of a lookup on the
+** from column and one on the to column, so that each can use an index.
+*/
+static int bfsvtabPrepareLookup(
+    bfsvtab_cursor *pCur,
+    const char *zTableName,
+    const char *zFromColumn,
+    const char *zToColumn,
+    const char *zWeightColumn
+) {
+    bfsvtab_vtab *pVtab = pCur->pVtab;
+    sqlite3_str *pStr;
+    char *zSql;
+    int rc;
+    int i, j;
+
+    if (pCur->nBatch > sqlite3_limit(pVtab->db, SQLITE_LIMIT_VARIABLE_NUMBER, -1)) {
+        pCur->nBatch = sqlite3_limit(pVtab->db, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+    }
+    if (pCur->nBatch < 1 || pCur->pDijkstra) {
+        pCur->nBatch = 1;
+    }
+
+    pStr = sqlite3_str_new(pVtab->db);
+    for (i = 0; i < (pCur->eDirection == BFSVTAB_DIRECTION_BOTH ? 2 : 1); i++) {
+        const char *zFrom = i ? zToColumn : zFromColumn;
+        const char *zTo = i ? zFromColumn : zToColumn;
+        if (i) {
+            sqlite3_str_appendall(pStr, " UNION ALL ");
+        }
+        if (zWeightColumn) {
+            sqlite3_str_appendf(pStr,
+                "SELECT \"%w\".\"%w\", \"%w\".\"%w\" FROM \"%w\" "
+                "WHERE \"%w\".\"%w\"=?1",
+                zTableName, zTo, zTableName, zWeightColumn, zTableName,
+                zTableName, zFrom);
+        } else if (pCur->nBatch > 1) {
+            sqlite3_str_appendf(pStr,
+                "SELECT \"%w\".\"%w\", \"%w\".\"%w\" FROM \"%w\" "
+                "WHERE \"%w\".\"%w\" IN (?1",
+                zTableName, zFrom, zTableName, zTo, zTableName,
+                zTableName, zFrom);
+            for (j = 2; j <= pCur->nBatch; j++) {
+                sqlite3_str_appendf(pStr, ",?%d", j);
+            }
+            sqlite3_str_appendchar(pStr, 1, ')');
+        } else {
+            sqlite3_str_appendf(pStr,
+                "SELECT \"%w\".\"%w\" FROM \"%w\" WHERE \"%w\".\"%w\"=?1",
+                zTableName, zTo, zTableName, zTableName, zFrom);
+        }
+    }
+    zSql = sqlite3_str_finish(pStr);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+
+    if (pCur->nBatch > 1) {
+        pCur->batch.nMax = pCur->nBatch;
+        pCur->batch.aNode = sqlite3_malloc64(
+            pCur->nBatch * sizeof(sqlite3_int64));
+        pCur->batch.aEnd = sqlite3_malloc64(
+            pCur->nBatch * sizeof(sqlite3_int64));
+        if (pCur->batch.aNode == 0 || pCur->batch.aEnd == 0) {
+            sqlite3_free(zSql);
+            return SQLITE_NOMEM;
+        }
+    }
+
+    rc = bfsvtabStmtAcquire(pVtab, zSql, &pCur->pStmt);
+    sqlite3_free(zSql);
+    if (rc) {
+      sqlite3_free(pVtab->base.zErrMsg);
+      pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+      return rc;
+    }
     return SQLITE_OK;
 }
 
 /*
-** Advance a bfsvtab_cursor to its next row of output.
+** Set *pbIndexed to true if some index on table zTableName has column
+** zColumn as its leftmost column, or if zColumn is the rowid, either by
+** name or as an INTEGER PRIMARY KEY.  Without one, looking up the nodes
+** with an edge to a given node means scanning the whole table.
 */
-static int bfsvtabNext(sqlite3_vtab_cursor *cur) {
+static int bfsvtabIsIndexed(
+    bfsvtab_vtab *pVtab,
+    const char *zTableName,
+    const char *zColumn,
+    int *pbIndexed
+) {
+    sqlite3_stmt *pStmt;
     int rc;
-    bfsvtab_avl *newAvlNode;
-    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
-    if (pCur->pCurrent) {
-        sqlite3_free(pCur->pCurrent);
-    }
-    pCur->pCurrent = queuePull(&pCur->pQueue);
-    if (pCur->pCurrent == 0) {
-        return SQLITE_OK;
-    }
-    rc = sqlite3_bind_int64(pCur->pStmt, 1, pCur->pCurrent->id);
-    if (rc) {
-        return rc;
-    }
-    while (rc == SQLITE_OK && sqlite3_step(pCur->pStmt) == SQLITE_ROW) {
-        if (sqlite3_column_type(pCur->pStmt, 0) == SQLITE_INTEGER) {
-            sqlite3_int64 iNew = sqlite3_column_int64(pCur->pStmt, 0);
-            if (bfsvtabAvlSearch(pCur->pVisited, iNew) != 0) {
-                continue;
-            }
-            bfsvtab_node *node = sqlite3_malloc(sizeof(*node));
-            if (node == 0) {
-                return SQLITE_NOMEM;
-            }
-            memset(node, 0, sizeof(*node));
-            node->id = iNew;
-            node->parent = pCur->pCurrent->id;
-            node->distance = pCur->pCurrent->distance + 1;
-            queuePush(&pCur->pQueue, node);
 
-            newAvlNode = sqlite3_malloc(sizeof(*newAvlNode));
-            if (newAvlNode == 0) {
-                return SQLITE_NOMEM;
-            }
-            memset(newAvlNode, 0, sizeof(*newAvlNode));
-            newAvlNode->id = iNew;
-            newAvlNode->parent = pCur->pCurrent->id;
-            bfsvtabAvlInsert(&pCur->pVisited, newAvlNode);
-        }
-    }
-    rc = sqlite3_clear_bindings(pCur->pStmt);
-    if (rc) {
+    *pbIndexed = 0;
+    rc = bfsvtabStmtAcquire(pVtab,
+        "SELECT 1 FROM pragma_index_list(?1) AS l, pragma_index_info(l.name) AS i"
+        " WHERE i.seqno = 0 AND i.name = ?2 COLLATE nocase"
+        " UNION ALL"
+        " SELECT 1 FROM pragma_table_info(?1)"
+        " WHERE pk = 1 AND upper(type) = 'INTEGER' AND name = ?2 COLLATE nocase"
+        " AND (SELECT count(*) FROM pragma_table_info(?1) WHERE pk > 0) = 1"
+        " UNION ALL"
+        " SELECT 1 WHERE lower(?2) IN ('rowid', 'oid', '_rowid_')"
+        " AND NOT EXISTS (SELECT 1 FROM pragma_table_info(?1)"
+        " WHERE name = ?2 COLLATE nocase)",
+        &pStmt);
+    if (rc != SQLITE_OK) {
         return rc;
     }
-    rc = sqlite3_reset(pCur->pStmt);
-    if (rc) {
-        return rc;
+    sqlite3_bind_text(pStmt, 1, zTableName, -1, SQLITE_STATIC);
+    sqlite3_bind_text(pStmt, 2, zColumn, -1, SQLITE_STATIC);
+    if (sqlite3_step(pStmt) == SQLITE_ROW) {
+        *pbIndexed = 1;
     }
+    rc = sqlite3_reset(pStmt);
+    bfsvtabStmtRelease(pVtab, pStmt);
     return rc;
 }
 
 /*
-** Recursively builds a node path string.
+** Set *pnRow to the number of rows in table zTableName.  Counting them
+** reads the whole table, so the count is kept in pVtab until the data
+** versions say that a database has changed.  A read transaction must be
+** open on the database that holds the table.
 */
-int bfsvtabBuildShortestPathStr(sqlite3_str *str, bfsvtab_avl *visited, sqlite3_int64 id) {
+static int bfsvtabRowCount(
+    bfsvtab_vtab *pVtab,
+    const char *zTableName,
+    sqlite3_int64 *pnRow
+) {
+    sqlite3_stmt *pStmt;
+    sqlite3_uint64 iVersion;
+    char *zSql;
+    int nChange;
     int rc;
-    bfsvtab_avl *node = bfsvtabAvlSearch(visited, id);
-    if (node == 0) {
+
+    bfsvtabDataVersion(pVtab->db, &iVersion, &nChange);
+    if (pVtab->zCountTable && strcmp(pVtab->zCountTable, zTableName) == 0
+        && pVtab->iCountVersion == iVersion && pVtab->nCountChange == nChange) {
+        *pnRow = pVtab->nCount;
         return SQLITE_OK;
     }
-    if (node->parent != id) {
-        rc = bfsvtabBuildShortestPathStr(str, visited, node->parent);
-        if (rc != SQLITE_OK) {
-            return rc;
-        }
-        sqlite3_str_appendf(str, "%d/", id);
-        rc = sqlite3_str_errcode(str);
+    sqlite3_free(pVtab->zCountTable);
+    pVtab->zCountTable = 0;
+    zSql = sqlite3_mprintf("SELECT count(*) FROM \"%w\"", zTableName);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = bfsvtabStmtAcquire(pVtab, zSql, &pStmt);
+    sqlite3_free(zSql);
+    if (rc != SQLITE_OK) {
         return rc;
     }
-    sqlite3_str_appendf(str, "/%d/", id);
-    rc = sqlite3_str_errcode(str);
+    *pnRow = sqlite3_step(pStmt) == SQLITE_ROW ? sqlite3_column_int64(pStmt, 0) : 0;
+    rc = sqlite3_reset(pStmt);
+    bfsvtabStmtRelease(pVtab, pStmt);
+    if (rc == SQLITE_OK) {
+        pVtab->zCountTable = sqlite3_mprintf("%s", zTableName);
+        pVtab->nCount = *pnRow;
+        pVtab->iCountVersion = iVersion;
+        pVtab->nCountChange = nChange;
+    }
     return rc;
 }
 
 /*
-** Return values of columns for the row at which the bfsvtab_cursor
-** is currently pointing.
+** Find the smallest and largest values in column zColumn of table
+** zTableName.  If both are integers, set *piMin and *piMax to them and
+** *pbFound to true.  Otherwise, for example if the table is empty, set
+** *pbFound to false.  If pnRow is not NULL, also set *pnRow to the
+** number of rows in the table (see bfsvtabRowCount()).
 */
-static int bfsvtabColumn(
-    sqlite3_vtab_cursor *cur,   /* The cursor */
-    sqlite3_context *ctx,       /* First argument to sqlite3_result_...() */
-    int i                       /* Which column to return */
+static int bfsvtabColumnRange(
+    bfsvtab_vtab *pVtab,
+    const char *zTableName,
+    const char *zColumn,
+    sqlite3_int64 *piMin,
+    sqlite3_int64 *piMax,
+    sqlite3_int64 *pnRow,
+    int *pbFound
 ) {
+    sqlite3_stmt *pStmt;
+    char *zSql;
     int rc;
-    sqlite3_str *s;
-    char *c;
-    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
-    switch (i) {
-        case BFSVTAB_COL_ID:
-            sqlite3_result_int64(ctx, pCur->pCurrent->id);
-            break;
-        case BFSVTAB_COL_PARENT:
-            if (pCur->pCurrent->id == pCur->root) {
-                sqlite3_result_null(ctx);
-            } else {
-                sqlite3_result_int(ctx, pCur->pCurrent->parent);
-            }
-            break;
-        case BFSVTAB_COL_DISTANCE:
-            sqlite3_result_int(ctx, pCur->pCurrent->distance);
-            break;
-        case BFSVTAB_COL_SHORTEST_PATH:
-            s = sqlite3_str_new(pCur->pVtab->db);
-            rc = sqlite3_str_errcode(s);
-            if (rc != SQLITE_OK) {
-                sqlite3_str_finish(s);
-                return rc;
-            }
-            rc = bfsvtabBuildShortestPathStr(s, pCur->pVisited, pCur->pCurrent->id);
-            if (rc != SQLITE_OK) {
-                sqlite3_str_finish(s);
-                return rc;
-            }
-            c = sqlite3_str_finish(s);
-            sqlite3_result_text(ctx, c, -1, SQLITE_TRANSIENT);
-            sqlite3_free(c);
-            break;
-        case BFSVTAB_COL_ROOT:
-            sqlite3_result_int(ctx, pCur->root);
-            break;
-        case BFSVTAB_COL_TABLENAME:
-            sqlite3_result_text(ctx,
-                    pCur->zTableName ?
-                        pCur->zTableName : pCur->pVtab->zTableName,
-                    -1, SQLITE_TRANSIENT);
-            break;
-        case BFSVTAB_COL_FROMCOLUMN:
-            sqlite3_result_text(ctx,
-                    pCur->zFromColumn ?
-                        pCur->zFromColumn : pCur->pVtab->zFromColumn,
-                    -1, SQLITE_TRANSIENT);
-            break;
-        default:
-            assert( i==BFSVTAB_COL_TOCOLUMN );
-            sqlite3_result_text(ctx,
-                    pCur->zToColumn ?
-                        pCur->zToColumn : pCur->pVtab->zToColumn,
-                    -1, SQLITE_TRANSIENT);
-            break;
+
+    *pbFound = 0;
+    /* Separate subqueries, so that each can be answered from an index */
+    zSql = sqlite3_mprintf(
+        "SELECT (SELECT min(\"%w\".\"%w\") FROM \"%w\"),"
+        " (SELECT max(\"%w\".\"%w\") FROM \"%w\")",
+        zTableName, zColumn, zTableName, zTableName, zColumn, zTableName);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
     }
-    return SQLITE_OK;
+    rc = bfsvtabStmtAcquire(pVtab, zSql, &pStmt);
+    sqlite3_free(zSql);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    if (sqlite3_step(pStmt) == SQLITE_ROW
+        && sqlite3_column_type(pStmt, 0) == SQLITE_INTEGER
+        && sqlite3_column_type(pStmt, 1) == SQLITE_INTEGER) {
+        *piMin = sqlite3_column_int64(pStmt, 0);
+        *piMax = sqlite3_column_int64(pStmt, 1);
+        *pbFound = 1;
+    }
+    /* Counted while pStmt keeps the read transaction open */
+    rc = pnRow ? bfsvtabRowCount(pVtab, zTableName, pnRow) : SQLITE_OK;
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_reset(pStmt);
+    } else {
+        sqlite3_reset(pStmt);
+    }
+    bfsvtabStmtRelease(pVtab, pStmt);
+    return rc;
 }
 
 /*
-** Return the rowid for the current row.  In this implementation, the
-** rowid is the same as the output value.
+** Prepare the statement used to look up the nodes that have an edge to a
+** node, for searching backwards from the target.  When edges are followed
+** both ways, those are the same nodes as the neighbours.
 */
-static int bfsvtabRowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid) {
-    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
-    *pRowid = pCur->pCurrent->id;
-    return SQLITE_OK;
-}
+static int bfsvtabPrepareReverse(
+    bfsvtab_cursor *pCur,
+    const char *zTableName,
+    const char *zFromColumn,
+    const char *zToColumn
+) {
+    bfsvtab_vtab *pVtab = pCur->pVtab;
+    sqlite3_str *pStr;
+    char *zSql;
+    int rc;
+    int i;
 
-/*
-** Return TRUE if the cursor has been moved off of the last
-** row of output.
-*/
-static int bfsvtabEof(sqlite3_vtab_cursor *cur) {
-    bfsvtab_cursor *pCur = (bfsvtab_cursor*)cur;
-    return pCur->pCurrent == 0 && pCur->pQueue.pFirst == 0;
+    pStr = sqlite3_str_new(pVtab->db);
+    for (i = 0; i < (pCur->eDirection == BFSVTAB_DIRECTION_BOTH ? 2 : 1); i++) {
+        sqlite3_str_appendf(pStr,
+            "%sSELECT \"%w\".\"%w\" FROM \"%w\" WHERE \"%w\".\"%w\"=?1",
+            i ? " UNION ALL " : "",
+            zTableName, i ? zToColumn : zFromColumn, zTableName,
+            zTableName, i ? zFromColumn : zToColumn);
+    }
+    zSql = sqlite3_str_finish(pStr);
+    if (zSql == 0) {
+        return SQLITE_NOMEM;
+    }
+    rc = bfsvtabStmtAcquire(pVtab, zSql, &pCur->pRevStmt);
+    sqlite3_free(zSql);
+    if (rc) {
+      sqlite3_free(pVtab->base.zErrMsg);
+      pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+      return rc;
+    }
+    return SQLITE_OK;
 }
 
 /*
@@ -775,71 +6919,344 @@ static int bfsvtabFilter(
     int rc = SQLITE_OK;
     bfsvtab_cursor *pCur = (bfsvtab_cursor *)pVtabCursor;
     bfsvtab_vtab *pVtab = (bfsvtab_vtab *)pCur->pVtab;
-    char *zSql;
     const char *zTableName = pVtab->zTableName;
     const char *zFromColumn = pVtab->zFromColumn;
     const char *zToColumn = pVtab->zToColumn;
-    bfsvtab_node *root;
-    bfsvtab_avl *rootAvlNode;
+    const char *zWeightColumn = pVtab->zWeightColumn;
+    const char *zHeuristic = pVtab->zHeuristic;
+    sqlite3_value *pRoot = 0;
+    sqlite3_value *pDistance = 0;
+    sqlite3_value *pId = 0;
+    sqlite3_int64 iRoot;
+    int i;
 
-    (void)idxStr;
-    (void)argc;
     bfsvtabClearCursor(pCur);
     if ((idxNum & 1) == 0) {
         /* No root=$root in the WHERE clause.  Return an empty set */
         return SQLITE_OK;
     }
-    if( (idxNum & 0x00f00) != 0) {
-        zTableName = (const char*)sqlite3_value_text(argv[(idxNum>>8)&0x0f]);
-        pCur->zTableName = sqlite3_mprintf("%s", zTableName);
+    pCur->nBatch = pVtab->nBatch;
+    pCur->eAdjacency = pVtab->eAdjacency;
+    pCur->eEngine = pVtab->eEngine;
+    pCur->nThread = pVtab->nThread;
+    pCur->eVisited = pVtab->eVisited;
+    pCur->eSources = pVtab->eSources;
+    pCur->eDirection = pVtab->eDirection;
+    pCur->eRefresh = pVtab->eRefresh;
+    pCur->nMemLimit = pVtab->nMemLimit;
+    pCur->bParent = (idxNum & 0x20) == 0;
+    for (i = 0; i < argc; i++) {
+        switch (idxStr[i] - 'a') {
+            case BFSVTAB_COL_ROOT:
+                pRoot = argv[i];
+                break;
+            case BFSVTAB_COL_DISTANCE:
+                pDistance = argv[i];
+                break;
+            case BFSVTAB_COL_ID:
+                pId = argv[i];
+                break;
+            case BFSVTAB_COL_TABLENAME:
+                zTableName = (const char*)sqlite3_value_text(argv[i]);
+                pCur->zTableName = sqlite3_mprintf("%s", zTableName);
+                if (pCur->zTableName == 0) {
+                    return SQLITE_NOMEM;
+                }
+                break;
+            case BFSVTAB_COL_FROMCOLUMN:
+                zFromColumn = (const char*)sqlite3_value_text(argv[i]);
+                pCur->zFromColumn = sqlite3_mprintf("%s", zFromColumn);
+                if (pCur->zFromColumn == 0) {
+                    return SQLITE_NOMEM;
+                }
+                break;
+            case BFSVTAB_COL_TOCOLUMN:
+                zToColumn = (const char*)sqlite3_value_text(argv[i]);
+                pCur->zToColumn = sqlite3_mprintf("%s", zToColumn);
+                if (pCur->zToColumn == 0) {
+                    return SQLITE_NOMEM;
+                }
+                break;
+            case BFSVTAB_COL_WEIGHTCOLUMN:
+                zWeightColumn = (const char*)sqlite3_value_text(argv[i]);
+                pCur->zWeightColumn = sqlite3_mprintf("%s", zWeightColumn);
+                if (pCur->zWeightColumn == 0) {
+                    return SQLITE_NOMEM;
+                }
+                break;
+            case BFSVTAB_COL_HEURISTIC:
+                zHeuristic = (const char*)sqlite3_value_text(argv[i]);
+                pCur->zHeuristic = sqlite3_mprintf("%s", zHeuristic);
+                if (pCur->zHeuristic == 0) {
+                    return SQLITE_NOMEM;
+                }
+                break;
+            case BFSVTAB_COL_BATCHSIZE:
+                pCur->nBatch = sqlite3_value_int(argv[i]);
+                break;
+            case BFSVTAB_COL_ADJACENCY:
+                pCur->eAdjacency = bfsvtabAdjacencyMode(
+                        (const char*)sqlite3_value_text(argv[i]));
+                if (pCur->eAdjacency < 0) {
+                    pCur->eAdjacency = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "unknown adjacency: [%s]", sqlite3_value_text(argv[i]));
+                    return SQLITE_ERROR;
+                }
+                break;
+            case BFSVTAB_COL_THREADS:
+                pCur->nThread = sqlite3_value_int(argv[i]);
+                break;
+            case BFSVTAB_COL_MEMLIMIT:
+                pCur->nMemLimit = sqlite3_value_int64(argv[i]);
+                if (pCur->nMemLimit < 0) {
+                    pCur->nMemLimit = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "memlimit must not be negative");
+                    return SQLITE_ERROR;
+                }
+                break;
+            case BFSVTAB_COL_VISITED:
+                pCur->eVisited = bfsvtabVisitedMode(
+                        (const char*)sqlite3_value_text(argv[i]));
+                if (pCur->eVisited < 0) {
+                    pCur->eVisited = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "unknown visited: [%s]", sqlite3_value_text(argv[i]));
+                    return SQLITE_ERROR;
+                }
+                break;
+            case BFSVTAB_COL_SOURCES:
+                pCur->eSources = bfsvtabSourcesMode(
+                        (const char*)sqlite3_value_text(argv[i]));
+                if (pCur->eSources < 0) {
+                    pCur->eSources = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "unknown sources: [%s]", sqlite3_value_text(argv[i]));
+                    return SQLITE_ERROR;
+                }
+                break;
+            case BFSVTAB_COL_DIRECTION:
+                pCur->eDirection = bfsvtabDirectionMode(
+                        (const char*)sqlite3_value_text(argv[i]));
+                if (pCur->eDirection < 0) {
+                    pCur->eDirection = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "unknown direction: [%s]", sqlite3_value_text(argv[i]));
+                    return SQLITE_ERROR;
+                }
+                break;
+            case BFSVTAB_COL_REFRESH:
+                pCur->eRefresh = bfsvtabRefreshMode(
+                        (const char*)sqlite3_value_text(argv[i]));
+                if (pCur->eRefresh < 0) {
+                    pCur->eRefresh = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "unknown refresh: [%s]", sqlite3_value_text(argv[i]));
+                    return SQLITE_ERROR;
+                }
+                break;
+            case BFSVTAB_COL_ENGINE:
+                pCur->eEngine = bfsvtabEngineMode(
+                        (const char*)sqlite3_value_text(argv[i]));
+                if (pCur->eEngine < 0) {
+                    pCur->eEngine = 0;
+                    sqlite3_free(pVtab->base.zErrMsg);
+                    pVtab->base.zErrMsg = sqlite3_mprintf(
+                        "unknown engine: [%s]", sqlite3_value_text(argv[i]));
+                    return SQLITE_ERROR;
+                }
+                break;
+        }
+    }
+    assert(pRoot != 0);
+    if (pCur->eDirection == BFSVTAB_DIRECTION_REVERSE) {
+        /* Following the edges backwards is following the columns swapped */
+        const char *zSwap = zFromColumn;
+        zFromColumn = zToColumn;
+        zToColumn = zSwap;
     }
-    if( (idxNum & 0x0f000) != 0) {
-        zFromColumn = (const char*)sqlite3_value_text(argv[(idxNum>>12)&0x0f]);
-        pCur->zFromColumn = sqlite3_mprintf("%s", zFromColumn);
+    if (zWeightColumn && zWeightColumn[0] == 0) {
+        zWeightColumn = 0;
     }
-    if((idxNum & 0x0f0000) != 0) {
-        zToColumn = (const char*)sqlite3_value_text(argv[(idxNum>>16)&0x0f]);
-        pCur->zToColumn = sqlite3_mprintf("%s", zToColumn);
+    if (zHeuristic && (zHeuristic[0] == 0 || pId == 0 || (idxNum & 0x10) != 0
+                       || sqlite3_value_type(pId) != SQLITE_INTEGER)) {
+        /* A* needs a single target to aim at */
+        zHeuristic = 0;
     }
-
-    zSql = sqlite3_mprintf(
-        "SELECT \"%w\".\"%w\" FROM \"%w\" WHERE \"%w\".\"%w\"=?1",
-        zTableName, zToColumn, zTableName, zTableName, zFromColumn);
-    if (zSql == 0) {
-        return SQLITE_NOMEM;
+    if (zWeightColumn || zHeuristic) {
+        pCur->pDijkstra = sqlite3_malloc(sizeof(bfsvtab_dijkstra));
+        if (pCur->pDijkstra == 0) {
+            return SQLITE_NOMEM;
+        }
+        memset(pCur->pDijkstra, 0, sizeof(bfsvtab_dijkstra));
     }
-
-    rc = sqlite3_prepare_v2(pVtab->db, zSql, -1, &pCur->pStmt, 0);
-    sqlite3_free(zSql);
-    if (rc) {
-      sqlite3_free(pVtab->base.zErrMsg);
-      pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
-      return rc;
+    if (zHeuristic) {
+        char *zSql = sqlite3_mprintf("SELECT \"%w\"(?1, ?2)", zHeuristic);
+        if (zSql == 0) {
+            return SQLITE_NOMEM;
+        }
+        rc = bfsvtabStmtAcquire(pVtab, zSql, &pCur->pHeuristic);
+        sqlite3_free(zSql);
+        if (rc != SQLITE_OK) {
+            sqlite3_free(pVtab->base.zErrMsg);
+            pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+            return rc;
+        }
+        sqlite3_bind_value(pCur->pHeuristic, 2, pId);
+    }
+    bfsvtabSetDepth(pCur, idxNum, pDistance);
+    if (pCur->iMaxDepth < 0 || pCur->iMinDepth > pCur->iMaxDepth) {
+        /* No node can satisfy the distance constraint */
+        return SQLITE_OK;
+    }
+    rc = bfsvtabSetRoots(pCur, (idxNum & 0x40) != 0, pRoot);
+    if (rc != SQLITE_OK || pCur->roots.n == 0) {
+        return rc;
     }
 
-    root = sqlite3_malloc(sizeof(*root));
-    if (root == 0) {
-        return SQLITE_NOMEM;
+    if (pCur->eEngine == BFSVTAB_ENGINE_MSBFS
+        && ((idxNum & 0x80) != 0 || pCur->eSources == BFSVTAB_SOURCES_NEAREST
+            || pCur->pDijkstra)) {
+        /* Paths, and a single traversal from all roots, are left to the
+        ** queue, which keeps one parent per node */
+        pCur->eEngine = BFSVTAB_ENGINE_TOPDOWN;
+    }
+    if (pCur->pDijkstra && pCur->eEngine != BFSVTAB_ENGINE_TOPDOWN) {
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "engine %s cannot run a weighted or A* search",
+            azBfsvtabEngine[pCur->eEngine]);
+        return SQLITE_ERROR;
+    }
+    if (pCur->eEngine != BFSVTAB_ENGINE_TOPDOWN
+        && pCur->eAdjacency == BFSVTAB_ADJACENCY_LOOKUP) {
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "engine %s requires the in-memory adjacency",
+            azBfsvtabEngine[pCur->eEngine]);
+        return SQLITE_ERROR;
     }
-    memset(root, 0, sizeof(*root));
-    root->distance = 0;
-    root->id = sqlite3_value_int64(argv[0]);
-    root->parent = root->id;
-    queuePush(&pCur->pQueue, root);
 
-    pCur->pCurrent = 0;
-    pCur->root = root->id;
+    if (pCur->eAdjacency == BFSVTAB_ADJACENCY_STORED && pVtab->bShadow == 0) {
+        sqlite3_free(pVtab->base.zErrMsg);
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "adjacency stored requires a table made by CREATE VIRTUAL TABLE");
+        return SQLITE_ERROR;
+    }
+    if (pCur->eAdjacency == BFSVTAB_ADJACENCY_CSR
+        || pCur->eAdjacency == BFSVTAB_ADJACENCY_STORED
+        || pCur->eAdjacency == BFSVTAB_ADJACENCY_MAPPED
+        || pCur->eAdjacency == BFSVTAB_ADJACENCY_SHARED
+        || pCur->eEngine != BFSVTAB_ENGINE_TOPDOWN) {
+        rc = bfsvtabCsrAcquire(pVtab, zTableName, zFromColumn, zToColumn,
+                zWeightColumn, pCur->eDirection == BFSVTAB_DIRECTION_BOTH,
+                pCur->eAdjacency == BFSVTAB_ADJACENCY_STORED,
+                pCur->eRefresh == BFSVTAB_REFRESH_INCREMENTAL,
+                pCur->eAdjacency == BFSVTAB_ADJACENCY_MAPPED,
+                pCur->eAdjacency == BFSVTAB_ADJACENCY_SHARED, &pCur->pCsr);
+        if (rc) {
+            return rc;
+        }
+    } else {
+        rc = bfsvtabPrepareLookup(pCur, zTableName, zFromColumn, zToColumn,
+                zWeightColumn);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    }
+    iRoot = bfsvtabRootKey(pCur, 0);
+    if (pCur->eSources == BFSVTAB_SOURCES_NEAREST && pCur->roots.n > 1) {
+        /* The root of each row is found through its parents */
+        pCur->bParent = 1;
+    }
 
-    rootAvlNode = sqlite3_malloc(sizeof(*rootAvlNode));
-    if (rootAvlNode == 0) {
-        return SQLITE_NOMEM;
+    if (pId) {
+        rc = bfsvtabSetTargets(pCur, (idxNum & 0x10) != 0, pId);
+        if (rc != SQLITE_OK || pCur->nTarget == 0) {
+            return rc;
+        }
+        if (pCur->nTarget == 1 && pCur->pCsr == 0
+            && (pCur->iTarget != iRoot || pCur->roots.n > 1)
+            && (pCur->eSources == BFSVTAB_SOURCES_EACH || pCur->roots.n == 1)
+            && pCur->eEngine == BFSVTAB_ENGINE_TOPDOWN && pCur->pDijkstra == 0) {
+            /* A single target: bfsvtabBegin() finds the nodes on its
+            ** shortest paths first, provided edges can be followed
+            ** backwards cheaply. */
+            int bReverse = 1;
+            rc = bfsvtabIsIndexed(pVtab, zTableName, zToColumn, &bReverse);
+            if (rc == SQLITE_OK && bReverse) {
+                rc = bfsvtabPrepareReverse(pCur, zTableName, zFromColumn, zToColumn);
+            }
+            if (rc != SQLITE_OK) {
+                sqlite3_free(pVtab->base.zErrMsg);
+                pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+                return rc;
+            }
+        }
     }
-    memset(rootAvlNode, 0, sizeof(*rootAvlNode));
-    rootAvlNode->id = root->id;
-    rootAvlNode->parent = root->id;
-    pCur->pVisited = rootAvlNode;
 
-    return bfsvtabNext(pVtabCursor);
+    if (pCur->eEngine == BFSVTAB_ENGINE_TOPDOWN && pCur->pDijkstra == 0
+        && (pCur->eVisited == BFSVTAB_VISITED_DENSE
+            || (pCur->eVisited == BFSVTAB_VISITED_AUTO && pCur->pCsr))) {
+        /* Every node other than the root is a value of the to column, or
+        ** of either column when edges are followed both ways, so there
+        ** are at most nNode of them */
+        sqlite3_int64 iMin = 0;
+        sqlite3_int64 iMax = 0;
+        sqlite3_int64 nNode = 0;
+        int bFound = 1;
+        if (pCur->pCsr) {
+            iMax = pCur->pCsr->nNode + pCur->roots.n - 1;
+            nNode = iMax + 1;
+        } else {
+            rc = bfsvtabColumnRange(pVtab, zTableName, zToColumn, &iMin, &iMax,
+                                    &nNode, &bFound);
+            if (pCur->eDirection == BFSVTAB_DIRECTION_BOTH) {
+                nNode *= 2;
+            }
+            nNode += pCur->roots.n;
+            if (rc == SQLITE_OK && bFound
+                && pCur->eDirection == BFSVTAB_DIRECTION_BOTH) {
+                sqlite3_int64 iFromMin = 0;
+                sqlite3_int64 iFromMax = 0;
+                rc = bfsvtabColumnRange(pVtab, zTableName, zFromColumn,
+                                        &iFromMin, &iFromMax, 0, &bFound);
+                if (iFromMin < iMin) iMin = iFromMin;
+                if (iFromMax > iMax) iMax = iFromMax;
+            }
+            if (rc != SQLITE_OK) {
+                sqlite3_free(pVtab->base.zErrMsg);
+                pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+                return rc;
+            }
+            for (i = 0; i < pCur->roots.n; i++) {
+                if (pCur->roots.a[i] < iMin) iMin = pCur->roots.a[i];
+                if (pCur->roots.a[i] > iMax) iMax = pCur->roots.a[i];
+            }
+        }
+        /* A range much wider than the graph, such as a few large ids,
+        ** would make the arrays far bigger than a hash table */
+        if (bFound && (sqlite3_uint64)iMax - (sqlite3_uint64)iMin < BFSVTAB_MAX_DENSE
+            && (iMax - iMin) / BFSVTAB_DENSE_SPREAD < nNode) {
+            sqlite3_int64 nDense = iMax - iMin + 1;
+            sqlite3_int64 nByte = ((nDense + 63) / 64) * sizeof(sqlite3_uint64)
+                                + (pCur->bParent ? nDense * sizeof(sqlite3_int64) : 0);
+            /* Under a memlimit the arrays would exceed, auto keeps to the
+            ** hash table, which only grows with the nodes reached */
+            if (pCur->eVisited == BFSVTAB_VISITED_DENSE
+                || pCur->nMemLimit == 0 || nByte <= pCur->nMemLimit) {
+                bfsvtabVisitedDense(pCur, iMin, nDense);
+            }
+        }
+    }
+    return bfsvtabNext(&pCur->base);
 }
 
 /*
@@ -851,24 +7268,40 @@ static int bfsvtabFilter(
 /*
 ** Search for terms of these forms:
 **
-**   (A)    root = $root
+**   (A)    root = $root  or  root IN (...)
 **   (B1)   distance < $distance
 **   (B2)   distance <= $distance
 **   (B3)   distance = $distance
 **   (C)    tablename = $tablename
-**   (D)    idcolumn = $idcolumn
-**   (E)    parentcolumn = $parentcolumn
+**   (D)    fromcolumn = $fromcolumn
+**   (E)    tocolumn = $tocolumn
+**   (F)    batchsize = $batchsize
+**   (G)    adjacency = $adjacency
+**   (H)    id = $id  or  id IN (...)
+**   (I)    engine = $engine
+**   (J)    threads = $threads
+**   (K)    visited = $visited
+**   (L)    sources = $sources
+**   (M)    weightcolumn = $weightcolumn
+**   (N)    heuristic = $heuristic
+**   (O)    direction = $direction
+**   (P)    refresh = $refresh
+**   (Q)    memlimit = $memlimit
 **
-** 
+** Each term that is used is passed to xFilter as one entry of argv[].
+** The idxStr is a string with one character per argv[] entry, 'a'
+** plus the column number of the constrained column, so that xFilter
+** can tell which entry is which.
 **
 **   idxNum       meaning
 **   ----------   ------------------------------------------------------
 **   0x00000001   Term of the form (A) found
-**   0x00000002   The term of bit-2 is like (B1)
-**   0x000000f0   Index in filter.argv[] of $depth.  0 if not used.
-**   0x00000f00   Index in filter.argv[] of $tablename.  0 if not used.
-**   0x0000f000   Index in filter.argv[] of $idcolumn.  0 if not used
-**   0x000f0000   Index in filter.argv[] of $parentcolumn.  0 if not used.
+**   0x00000002   The term of the distance column is like (B1)
+**   0x00000008   The term of the distance column is like (B3)
+**   0x00000010   The term (H) is an IN whose values are passed all at once
+**   0x00000020   Neither the parent nor the shortest_path column is used
+**   0x00000040   The term (A) is an IN whose values are passed all at once
+**   0x00000080   The shortest_path column is used
 **
 ** There must be a term of type (A).  If there is not, then the index type
 ** is 0 and the query will return an empty set.
@@ -879,68 +7312,109 @@ static int bfsvtabBestIndex(
 ) {
     int iPlan = 0;
     int i;
-    int idx = 1;
+    int nArg = 0;                   /* Number of argv[] entries used */
+    char zIdx[BFSVTAB_NCOLUMN + 1]; /* Column of each argv[] entry */
+    unsigned int mUsed = 0;         /* Mask of columns with a term used */
+    int bUnique = 0;                /* True if at most one row is returned */
     const struct sqlite3_index_constraint *pConstraint;
     bfsvtab_vtab *pVtab = (bfsvtab_vtab*)tab;
     double rCost = 10000000.0;
 
     pConstraint = pIdxInfo->aConstraint;
     for (i=0; i<pIdxInfo->nConstraint; i++, pConstraint++) {
-        if (pConstraint->usable == 0) {
+        int iCol = pConstraint->iColumn;
+        if (pConstraint->usable == 0
+            || iCol < 0
+            || (mUsed & (1u << iCol)) != 0) {
             continue;
         }
-        if ((iPlan & 1) == 0 
-            && pConstraint->iColumn == BFSVTAB_COL_ROOT
-            && pConstraint->op == SQLITE_INDEX_CONSTRAINT_EQ) {
-
-            iPlan |= 1;
-            pIdxInfo->aConstraintUsage[i].argvIndex = 1;
-            pIdxInfo->aConstraintUsage[i].omit = 1;
-            rCost /= 100.0;
-        }
-        if ((iPlan & 0x0000f0) == 0
-            && pConstraint->iColumn == BFSVTAB_COL_DISTANCE
-            && (pConstraint->op == SQLITE_INDEX_CONSTRAINT_LT
-            || pConstraint->op == SQLITE_INDEX_CONSTRAINT_LE
-            || pConstraint->op == SQLITE_INDEX_CONSTRAINT_EQ)
-            ) {
-
-            iPlan |= idx<<4;
-            pIdxInfo->aConstraintUsage[i].argvIndex = ++idx;
-            if( pConstraint->op==SQLITE_INDEX_CONSTRAINT_LT ) iPlan |= 0x000002;
-            rCost /= 5.0;
-        }
-        if ((iPlan & 0x000f00) == 0
-            && pConstraint->iColumn == BFSVTAB_COL_TABLENAME
-            && pConstraint->op == SQLITE_INDEX_CONSTRAINT_EQ
-            ) {
-
-            iPlan |= idx<<8;
-            pIdxInfo->aConstraintUsage[i].argvIndex = ++idx;
-            pIdxInfo->aConstraintUsage[i].omit = 1;
-            rCost /= 5.0;
-        }
-        if((iPlan & 0x00f000) == 0
-            && pConstraint->iColumn == BFSVTAB_COL_FROMCOLUMN
-            && pConstraint->op == SQLITE_INDEX_CONSTRAINT_EQ
-            ) {
-
-            iPlan |= idx<<12;
-            pIdxInfo->aConstraintUsage[i].argvIndex = ++idx;
-            pIdxInfo->aConstraintUsage[i].omit = 1;
-        }
-        if ((iPlan & 0x0f0000) == 0
-            && pConstraint->iColumn == BFSVTAB_COL_TOCOLUMN
-            && pConstraint->op == SQLITE_INDEX_CONSTRAINT_EQ
-            ) {
-            iPlan |= idx<<16;
-            pIdxInfo->aConstraintUsage[i].argvIndex = ++idx;
-            pIdxInfo->aConstraintUsage[i].omit = 1;
-        }
-    }
-    if ((pVtab->zTableName == 0       && (iPlan & 0x000f00) == 0)
-        || (pVtab->zFromColumn == 0     && (iPlan & 0x00f000) == 0)
-        || (pVtab->zToColumn == 0 && (iPlan & 0x0f0000) == 0)
+        switch (iCol) {
+            case BFSVTAB_COL_ROOT:
+                if (pConstraint->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                    continue;
+                }
+                /* As for the id column, take all values of an IN at once
+                ** so that the roots can be searched from in one xFilter */
+                if (sqlite3_libversion_number() >= 3038000
+                    && sqlite3_vtab_in(pIdxInfo, i, -1)) {
+                    sqlite3_vtab_in(pIdxInfo, i, 1);
+                    iPlan |= 0x000040;
+                }
+                iPlan |= 1;
+                pIdxInfo->aConstraintUsage[i].omit = 1;
+                rCost /= 100.0;
+                break;
+            case BFSVTAB_COL_DISTANCE:
+                if (pConstraint->op != SQLITE_INDEX_CONSTRAINT_LT
+                    && pConstraint->op != SQLITE_INDEX_CONSTRAINT_LE
+                    && pConstraint->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                    continue;
+                }
+                if (pConstraint->op == SQLITE_INDEX_CONSTRAINT_LT) {
+                    iPlan |= 0x000002;
+                }
+                if (pConstraint->op == SQLITE_INDEX_CONSTRAINT_EQ) {
+                    iPlan |= 0x000008;
+                }
+                rCost /= 5.0;
+                break;
+            case BFSVTAB_COL_ID:
+                if (pConstraint->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                    continue;
+                }
+                /* Ask for all values of an IN operator at once, so that a
+                ** single traversal can look for all of them.  That needs
+                ** SQLite 3.38 or later.  Otherwise each value is passed
+                ** to a separate xFilter call. */
+                if (sqlite3_libversion_number() >= 3038000
+                    && sqlite3_vtab_in(pIdxInfo, i, -1)) {
+                    sqlite3_vtab_in(pIdxInfo, i, 1);
+                    iPlan |= 0x000010;
+                } else {
+                    bUnique = 1;
+                }
+                pIdxInfo->aConstraintUsage[i].omit = 1;
+                rCost /= 10.0;
+                break;
+            case BFSVTAB_COL_TABLENAME:
+                if (pConstraint->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                    continue;
+                }
+                pIdxInfo->aConstraintUsage[i].omit = 1;
+                rCost /= 5.0;
+                break;
+            case BFSVTAB_COL_FROMCOLUMN:
+            case BFSVTAB_COL_TOCOLUMN:
+            case BFSVTAB_COL_BATCHSIZE:
+            case BFSVTAB_COL_ADJACENCY:
+            case BFSVTAB_COL_ENGINE:
+            case BFSVTAB_COL_THREADS:
+            case BFSVTAB_COL_VISITED:
+            case BFSVTAB_COL_SOURCES:
+            case BFSVTAB_COL_WEIGHTCOLUMN:
+            case BFSVTAB_COL_HEURISTIC:
+            case BFSVTAB_COL_DIRECTION:
+            case BFSVTAB_COL_REFRESH:
+            case BFSVTAB_COL_MEMLIMIT:
+                if (pConstraint->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                    continue;
+                }
+                pIdxInfo->aConstraintUsage[i].omit = 1;
+                break;
+            default:
+                continue;
+        }
+        mUsed |= 1u << iCol;
+        zIdx[nArg] = (char)('a' + iCol);
+        pIdxInfo->aConstraintUsage[i].argvIndex = ++nArg;
+    }
+    zIdx[nArg] = 0;
+    if ((pVtab->zTableName == 0
+            && (mUsed & (1u << BFSVTAB_COL_TABLENAME)) == 0)
+        || (pVtab->zFromColumn == 0
+            && (mUsed & (1u << BFSVTAB_COL_FROMCOLUMN)) == 0)
+        || (pVtab->zToColumn == 0
+            && (mUsed & (1u << BFSVTAB_COL_TOCOLUMN)) == 0)
         ) {
 
         /* All of tablename, fromcolumn, and tocolumn must be specified
@@ -955,10 +7429,34 @@ static int bfsvtabBestIndex(
         ** error (because the argvIndex values are not contiguously assigned
         ** starting from 1).  */
         rCost *= 1e30;
-        for (i=0; i<pIdxInfo->nConstraint; i++, pConstraint++) {
+        for (i=0; i<pIdxInfo->nConstraint; i++) {
             pIdxInfo->aConstraintUsage[i].argvIndex = 0;
+            pIdxInfo->aConstraintUsage[i].omit = 0;
         }
         iPlan = 0;
+    } else {
+        pIdxInfo->idxStr = sqlite3_mprintf("%s", zIdx);
+        if (pIdxInfo->idxStr == 0) {
+            return SQLITE_NOMEM;
+        }
+        pIdxInfo->needToFreeIdxStr = 1;
+        if (bUnique && (iPlan & 0x000040) == 0) {
+            /* With all roots at once, there is a row for each root */
+            pIdxInfo->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+            pIdxInfo->estimatedRows = 1;
+        } else if (iPlan & 0x000010) {
+            pIdxInfo->estimatedRows = 10;
+        }
+    }
+    if (iPlan != 0
+        && (pIdxInfo->colUsed & ((((sqlite3_uint64)1) << BFSVTAB_COL_PARENT)
+                                 | (((sqlite3_uint64)1) << BFSVTAB_COL_SHORTEST_PATH))) == 0) {
+        /* Only the visited bits are needed, not the parent of each node */
+        iPlan |= 0x000020;
+    }
+    if (iPlan != 0
+        && (pIdxInfo->colUsed & (((sqlite3_uint64)1) << BFSVTAB_COL_SHORTEST_PATH)) != 0) {
+        iPlan |= 0x000080;
     }
     pIdxInfo->idxNum = iPlan;
     pIdxInfo->estimatedCost = rCost;
@@ -966,17 +7464,127 @@ static int bfsvtabBestIndex(
     return SQLITE_OK;
 }
 
+/*
+** The xUpdate method.  A bfsvtab table has no rows of its own, so the
+** only change it accepts is the rebuild command
+**
+**     INSERT INTO x(command) VALUES('rebuild')
+**
+** which saves the in-memory adjacency of the edge relation named by the
+** arguments of the table to its shadow tables, for adjacency = 'stored'
+** to load.  The hidden columns tablename, fromcolumn, tocolumn,
+** weightcolumn and direction can be given in the same INSERT to name a
+** different relation.
+*/
+static int bfsvtabUpdate(
+    sqlite3_vtab *pBase,
+    int argc,
+    sqlite3_value **argv,
+    sqlite_int64 *pRowid
+) {
+    bfsvtab_vtab *pVtab = (bfsvtab_vtab*)pBase;
+    const char *zTable = pVtab->zTableName;
+    const char *zFrom = pVtab->zFromColumn;
+    const char *zTo = pVtab->zToColumn;
+    const char *zWeight = pVtab->zWeightColumn;
+    const char *zCommand;
+    bfsvtab_csr *pCsr = 0;
+    int eDirection = pVtab->eDirection;
+    int bMain = 0;
+    int rc;
+
+    *pRowid = 0;
+    sqlite3_free(pVtab->base.zErrMsg);
+    pVtab->base.zErrMsg = 0;
+    if (argc == 1 || sqlite3_value_type(argv[0]) != SQLITE_NULL) {
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "bfsvtab tables only accept INSERT of a command");
+        return SQLITE_ERROR;
+    }
+    zCommand = (const char*)sqlite3_value_text(argv[2 + BFSVTAB_COL_COMMAND]);
+    if (zCommand == 0 || sqlite3_stricmp(zCommand, "rebuild") != 0) {
+        pVtab->base.zErrMsg = sqlite3_mprintf("unknown command: [%s]",
+                                              zCommand ? zCommand : "");
+        return SQLITE_ERROR;
+    }
+    if (pVtab->bShadow == 0) {
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "rebuild requires a table made by CREATE VIRTUAL TABLE");
+        return SQLITE_ERROR;
+    }
+    if (sqlite3_value_type(argv[2 + BFSVTAB_COL_TABLENAME]) != SQLITE_NULL) {
+        zTable = (const char*)sqlite3_value_text(argv[2 + BFSVTAB_COL_TABLENAME]);
+    }
+    if (sqlite3_value_type(argv[2 + BFSVTAB_COL_FROMCOLUMN]) != SQLITE_NULL) {
+        zFrom = (const char*)sqlite3_value_text(argv[2 + BFSVTAB_COL_FROMCOLUMN]);
+    }
+    if (sqlite3_value_type(argv[2 + BFSVTAB_COL_TOCOLUMN]) != SQLITE_NULL) {
+        zTo = (const char*)sqlite3_value_text(argv[2 + BFSVTAB_COL_TOCOLUMN]);
+    }
+    if (sqlite3_value_type(argv[2 + BFSVTAB_COL_WEIGHTCOLUMN]) != SQLITE_NULL) {
+        zWeight = (const char*)sqlite3_value_text(argv[2 + BFSVTAB_COL_WEIGHTCOLUMN]);
+    }
+    if (sqlite3_value_type(argv[2 + BFSVTAB_COL_DIRECTION]) != SQLITE_NULL) {
+        eDirection = bfsvtabDirectionMode(
+                (const char*)sqlite3_value_text(argv[2 + BFSVTAB_COL_DIRECTION]));
+        if (eDirection < 0) {
+            pVtab->base.zErrMsg = sqlite3_mprintf("unknown direction: [%s]",
+                sqlite3_value_text(argv[2 + BFSVTAB_COL_DIRECTION]));
+            return SQLITE_ERROR;
+        }
+    }
+    if (zTable == 0 || zFrom == 0 || zTo == 0) {
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "rebuild requires tablename, fromcolumn and tocolumn");
+        return SQLITE_ERROR;
+    }
+    if (eDirection == BFSVTAB_DIRECTION_REVERSE) {
+        /* Stored as xFilter() asks for it, with the columns swapped */
+        const char *zSwap = zFrom;
+        zFrom = zTo;
+        zTo = zSwap;
+    }
+    if (zWeight && zWeight[0] == 0) {
+        zWeight = 0;
+    }
+
+    /* The triggers that clear the stamp must be on the same database */
+    if (sqlite3_stricmp(pVtab->zDb, "main") == 0) {
+        rc = bfsvtabIsMainTable(pVtab->db, zTable, &bMain);
+        if (rc != SQLITE_OK) {
+            pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+            return rc;
+        }
+    }
+    if (bMain == 0) {
+        pVtab->base.zErrMsg = sqlite3_mprintf(
+            "rebuild requires the edge table and this table in the main database");
+        return SQLITE_ERROR;
+    }
+    rc = bfsvtabCsrBuild(pVtab->db, zTable, zFrom, zTo, zWeight,
+                         eDirection == BFSVTAB_DIRECTION_BOTH, &pCsr);
+    if (rc == SQLITE_OK) {
+        rc = bfsvtabStoredSave(pVtab, zTable, zFrom, zTo, zWeight,
+                               eDirection == BFSVTAB_DIRECTION_BOTH, pCsr);
+    }
+    if (rc != SQLITE_OK) {
+        pVtab->base.zErrMsg = sqlite3_mprintf("%s", sqlite3_errmsg(pVtab->db));
+    }
+    bfsvtabCsrUnref(pCsr);
+    return rc;
+}
+
 /*
 ** This following structure defines all the methods for the 
 ** virtual table.
 */
 static sqlite3_module bfsvtabModule = {
-    /* iVersion    */ 0,
+    /* iVersion    */ 3,
     /* xCreate     */ bfsvtabConnect,
     /* xConnect    */ bfsvtabConnect,
     /* xBestIndex  */ bfsvtabBestIndex,
     /* xDisconnect */ bfsvtabDisconnect,
-    /* xDestroy    */ bfsvtabDisconnect,
+    /* xDestroy    */ bfsvtabDestroy,
     /* xOpen       */ bfsvtabOpen,
     /* xClose      */ bfsvtabClose,
     /* xFilter     */ bfsvtabFilter,
@@ -984,17 +7592,18 @@ static sqlite3_module bfsvtabModule = {
     /* xEof        */ bfsvtabEof,
     /* xColumn     */ bfsvtabColumn,
     /* xRowid      */ bfsvtabRowid,
-    /* xUpdate     */ 0,
+    /* xUpdate     */ bfsvtabUpdate,
     /* xBegin      */ 0,
     /* xSync       */ 0,
     /* xCommit     */ 0,
     /* xRollback   */ 0,
     /* xFindMethod */ 0,
-    /* xRename     */ 0,
+    /* xRename     */ bfsvtabRename,
     /* xSavepoint  */ 0,
     /* xRelease    */ 0,
     /* xRollbackTo */ 0,
-    /* xShadowName */ 0
+    /* xShadowName */ bfsvtabShadowName,
+    /* xIntegrity  */ 0
 };
 
 
@@ -1006,9 +7615,16 @@ int sqlite3_bfsvtab_init(
     char **pzErrMsg, 
     const sqlite3_api_routines *pApi
 ) {
+    bfsvtab_shared *pShared;
     int rc = SQLITE_OK;
     (void)pzErrMsg;
     SQLITE_EXTENSION_INIT2(pApi);
-    rc = sqlite3_create_module(db, "bfsvtab", &bfsvtabModule, 0);
+    pShared = bfsvtabSharedAcquire();
+    if (pShared == 0) {
+        return SQLITE_NOMEM;
+    }
+    /* On failure this calls bfsvtabSharedRelease() itself */
+    rc = sqlite3_create_module_v2(db, "bfsvtab", &bfsvtabModule, pShared,
+                                  bfsvtabSharedRelease);
     return rc;
 }
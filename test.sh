@@ -1,5 +1,17 @@
 #!/bin/bash
 
+# The file-backed tests use test/bfsvtab.db and the files made next to it
+rm -f test/bfsvtab.db test/bfsvtab.db-*
 valgrind --leak-check=full --show-leak-kinds=all --keep-debuginfo=yes -s sqlite3 < test/bfsvtab.sql
 
-cmp <(sqlite3 < test/rcte.sql) <(sqlite3 < test/bfsvtab.sql)
+rm -f test/bfsvtab.db test/bfsvtab.db-*
+# The queries that must fail, such as those over their memlimit, are
+# checked by their errors, which are compared with test/bfsvtab.err
+cmp <(sqlite3 < test/rcte.sql) <(sqlite3 < test/bfsvtab.sql 2>test/bfsvtab.db-err)
+status=$?
+if [ $status -eq 0 ]; then
+    cmp test/bfsvtab.err test/bfsvtab.db-err
+    status=$?
+fi
+rm -f test/bfsvtab.db test/bfsvtab.db-*
+exit $status
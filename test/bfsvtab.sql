@@ -6,3 +6,243 @@ create virtual table bfs using bfsvtab(
   tocolumn='toNode',
 );
 select id, parent, shortest_path, distance from bfs where root = 1;
+select id, parent, shortest_path, distance from bfs where root = 1 and adjacency = 'lookup' and batchsize = 3;
+select id, parent, shortest_path, distance from bfs where root = 1 and adjacency = 'csr';
+insert into edges(fromNode, toNode) values (10, 11);
+select id, parent, shortest_path, distance from bfs where root = 1 and adjacency = 'csr';
+select id, parent, shortest_path, distance from bfs where root = 1 and distance <= 3;
+select id, parent, shortest_path, distance from bfs where root = 1 and distance = 4 and adjacency = 'csr';
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 4;
+select id, parent, shortest_path, distance from bfs where root = 1 and id in (8, 4, 99) and adjacency = 'csr';
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 11 and adjacency = 'csr';
+create index edges_to on edges(toNode);
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 11 and distance <= 3;
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 99;
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 8;
+select id, parent, shortest_path, distance from bfs where root = 1 and engine = 'diropt';
+select id, parent, shortest_path, distance from bfs where root = 1 and engine = 'diropt' and distance <= 3;
+select id, parent, shortest_path, distance from bfs where root = 1 and engine = 'diropt' and id in (8, 4, 99);
+select id, parent, shortest_path, distance from bfs where root = 1 and engine = 'diropt' and threads = 4;
+select bfs.id, bfs.distance from (select 1 as r union all select 1) as roots join bfs on bfs.root = roots.r and bfs.adjacency = 'lookup';
+select id, parent, shortest_path, distance from bfs where root = 1 and adjacency = 'lookup' and visited = 'dense';
+select id, parent, shortest_path, distance from bfs where root = 1 and adjacency = 'csr' and visited = 'sparse';
+select id, distance from bfs where root = 1 and adjacency = 'csr';
+select root, id, distance from bfs where root in (7, 1, 7);
+select root, id, distance from bfs where root in (7, 1) and sources = 'nearest';
+select root, id, distance from bfs where root in (7, 1) and sources = 'nearest' and engine = 'diropt';
+select root, id, distance from bfs where root in (7, 1) and engine = 'msbfs';
+select root, id, distance from bfs where root in (7, 1) and id = 8 order by root;
+create table wedges as select fromNode, toNode, (fromNode * 7 + toNode) % 4 + 1 as w from edges;
+select id, distance, hops from bfs where root = 1 and tablename = 'wedges' and weightcolumn = 'w' order by distance, id;
+select id, distance, hops from bfs where root = 1 and tablename = 'wedges' and weightcolumn = 'w' and adjacency = 'lookup' and distance <= 8 order by distance, id;
+select id, distance from bfs where root = 1 and id = 10 and heuristic = 'glob';
+select id, distance from bfs where root = 1 and id = 10 and tablename = 'wedges' and weightcolumn = 'w' and adjacency = 'lookup';
+select id, distance from bfs where root = 1 and id = 10 and tablename = 'wedges' and weightcolumn = 'w' and heuristic = 'glob' and adjacency = 'lookup';
+select id, distance from bfs where root = 1 and id = 10 and heuristic = 'glob' and distance <= 6;
+create table agraph(fromNode integer, toNode integer, w);
+insert into agraph(fromNode, toNode, w) values (1, 7, 1), (1, 5, 2), (7, 10, 4), (5, 10, 2);
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 10 and tablename = 'agraph' and weightcolumn = 'w';
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 10 and tablename = 'agraph' and weightcolumn = 'w' and heuristic = 'glob';
+create table astar(fromNode integer, toNode integer, w);
+insert into astar(fromNode, toNode, w) values (1, 2, 1.6), (2, 10, 1.6), (1, 10, 5);
+with recursive n(i) as (select 101 union all select i + 1 from n where i < 150) insert into astar(fromNode, toNode, w) select 1, i, 2 from n union all select i, i + 100, 2 from n union all select i, i + 101, 2 from n where i < 150;
+.trace ./test/bfsvtab.db-trace
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 10 and tablename = 'astar' and weightcolumn = 'w' and heuristic = 'atan2';
+select id, parent, shortest_path, distance from bfs where root = 1 and id = 10 and tablename = 'astar' and weightcolumn = 'w' and heuristic = 'glob';
+.trace off
+select (length(t) - length(replace(t, '"atan2"(', ''))) / 8, (length(t) - length(replace(t, '"glob"(', ''))) / 7 from (select readfile('./test/bfsvtab.db-trace') as t);
+select id, distance from bfs where root = 10 and direction = 'reverse' order by distance, id;
+select id, distance from bfs where root = 4 and direction = 'both' and adjacency = 'lookup' order by distance, id;
+select id, distance from bfs where root = 4 and direction = 'both' and adjacency = 'csr' order by distance, id;
+create virtual table sbfs using bfsvtab(tablename='edges', fromcolumn='fromNode', tocolumn='toNode', adjacency='stored');
+select id, parent, shortest_path, distance from sbfs where root = 1;
+create virtual table ibfs using bfsvtab(tablename='edges', fromcolumn='fromNode', tocolumn='toNode', adjacency='csr', refresh='incremental');
+select id, distance from ibfs where root = 1 order by distance, id;
+insert into edges(fromNode, toNode) values (11, 12), (2, 11);
+delete from edges where fromNode = 10 and toNode = 11;
+update edges set toNode = 5 where fromNode = 6 and toNode = 7;
+select id, parent, shortest_path, distance from ibfs where root = 1;
+select id, distance from ibfs where root = 4 and direction = 'both' order by distance, id;
+create table redges(id integer primary key, fromNode integer, toNode integer);
+insert into redges(id, fromNode, toNode) values (1, 1, 2), (2, 2, 3);
+create virtual table rbfs using bfsvtab(tablename='redges', fromcolumn='fromNode', tocolumn='toNode', adjacency='csr', refresh='incremental');
+select id, distance from rbfs where root = 1 order by distance, id;
+.trace ./test/bfsvtab.db-trace
+insert or replace into redges(id, fromNode, toNode) values (2, 2, 4);
+select id, distance from rbfs where root = 1 order by distance, id;
+insert or ignore into redges(id, fromNode, toNode) values (1, 1, 5);
+select id, distance from rbfs where root = 1 order by distance, id;
+.trace off
+select 'replaced row not logged' from (select readfile('./test/bfsvtab.db-trace') as t) where instr(t, 'SELECT "redges"."fromNode"') > 0 or instr(t, 'FROM "redges" LIMIT 1') = 0;
+pragma recursive_triggers = on;
+insert or replace into redges(id, fromNode, toNode) values (2, 2, 5);
+select id, distance from rbfs where root = 1 order by distance, id;
+pragma recursive_triggers = off;
+drop table redges;
+create table redges(id integer primary key, fromNode integer, toNode integer);
+insert into redges(id, fromNode, toNode) values (1, 1, 3), (2, 3, 6);
+select id, distance from rbfs where root = 1 order by distance, id;
+insert into redges(id, fromNode, toNode) values (3, 6, 7);
+select id, distance from rbfs where root = 1 order by distance, id;
+select id, parent, shortest_path, distance from bfs where root = 1 and adjacency = 'mapped';
+select id, distance from bfs where root = 4 and direction = 'both' and adjacency = 'mapped' order by distance, id;
+select id, distance from bfs where root = 1 and adjacency = 'shared' and engine = 'diropt' order by distance, id;
+select id, distance from bfs where root = 1 and memlimit = 1000000 order by distance, id;
+select id, distance from bfs where root = 1 and engine = 'diropt' and memlimit = 1000000 order by distance, id;
+select id, distance from bfs where root = 1 and memlimit = 1 order by distance, id;
+create table wide(fromNode integer, toNode integer);
+with recursive n(i) as (select 10 union all select i + 1 from n where i < 20000) insert into wide(fromNode, toNode) select i, i + 1 from n;
+insert into wide(fromNode, toNode) values (1, 2), (2, 3);
+create virtual table wbfs using bfsvtab(tablename='wide', fromcolumn='fromNode', tocolumn='toNode', adjacency='csr');
+select id, parent, distance from wbfs where root = 1 and memlimit = 10000 order by distance, id;
+select id, parent, distance from wbfs where root = 1 and visited = 'dense' and memlimit = 10000 order by distance, id;
+begin;
+insert into wide(fromNode, toNode) values (3, 4);
+select count(*) from wbfs where root = 1 and memlimit = 1;
+select id, parent, distance from wbfs where root = 1 and memlimit = 10000 order by distance, id;
+commit;
+select count(*) from wide;
+create table tree(id integer primary key, parent integer);
+create index tree_parent on tree(parent);
+insert into tree(id, parent) values (1, null), (2, 1), (3, 1), (4, 2), (5, 4), (6, 3);
+create virtual table tbfs using bfsvtab(tablename='tree', fromcolumn='parent', tocolumn='id');
+create virtual table rtbfs using bfsvtab(tablename='tree', fromcolumn='parent', tocolumn='rowid');
+select id, parent, shortest_path, distance from tbfs where root = 1 and id = 5;
+select id, parent, shortest_path, distance from rtbfs where root = 1 and id = 6;
+create table star(fromNode integer, toNode integer);
+create index star_from on star(fromNode);
+with recursive n(i) as (select 2 union all select i + 1 from n where i < 10001) insert into star(fromNode, toNode) select 1, i from n union all select i, i + 10000 from n;
+create virtual table starbfs using bfsvtab(tablename='star', fromcolumn='fromNode', tocolumn='toNode', engine='diropt', threads=4);
+select count(*), sum(parent), sum(distance), sum(id * distance) from starbfs where root = 1;
+with recursive n(i) as (select 100000 union all select i + 1 from n where i < 250000) insert into star(fromNode, toNode) select i, i + 1 from n;
+select count(*), sum(parent), sum(distance), sum(id * distance) from starbfs where root = 1;
+select 'memlimit not checked under an id filter' from starbfs where root in (1, 100000) and id = 100001 and memlimit = 1500000;
+select 'memlimit not checked under a distance filter' from starbfs where root in (1, 100000) and distance = 3 and memlimit = 1500000;
+create table far(fromNode integer, toNode integer);
+insert into far(fromNode, toNode) values (1, 2), (2, 4000000000);
+create virtual table fbfs using bfsvtab(tablename='far', fromcolumn='fromNode', tocolumn='toNode', adjacency='lookup');
+select id, parent, distance from fbfs where root = 1 and visited = 'dense' and memlimit = 100000 order by distance, id;
+.trace ./test/bfsvtab.db-trace
+select id, parent, distance from fbfs where root = 1 and visited = 'dense' and memlimit = 100000 order by distance, id;
+.trace off
+select 'edge rows counted again' from (select readfile('./test/bfsvtab.db-trace') as t) where instr(t, 'SELECT count(*) FROM "far"') > 0 or instr(t, 'min("far"."toNode")') = 0;
+insert into far(fromNode, toNode) values (4000000000, 3);
+.trace ./test/bfsvtab.db-trace
+select id, parent, distance from fbfs where root = 1 and visited = 'dense' and memlimit = 100000 order by distance, id;
+.trace off
+select 'edge rows not counted after a change' from (select readfile('./test/bfsvtab.db-trace') as t) where instr(t, 'SELECT count(*) FROM "far"') = 0;
+attach './test/bfsvtab.db-aux' as aux;
+create table aux.aedges(fromNode integer, toNode integer);
+insert into aux.aedges(fromNode, toNode) values (1, 2), (2, 3);
+select id, distance from bfsvtab where tablename = 'aedges' and fromcolumn = 'fromNode' and tocolumn = 'toNode' and root = 1 and adjacency = 'csr' order by distance, id;
+.connection 1
+.open ./test/bfsvtab.db-aux
+insert into aedges(fromNode, toNode) values (3, 4);
+.connection 0
+select id, distance from bfsvtab where tablename = 'aedges' and fromcolumn = 'fromNode' and tocolumn = 'toNode' and root = 1 and adjacency = 'csr' order by distance, id;
+detach aux;
+.connection 1
+.open --new ./test/bfsvtab.db
+.load ./bfsvtab
+.read ./test/fixture.sql
+create virtual table sbfs using bfsvtab(tablename='edges', fromcolumn='fromNode', tocolumn='toNode', adjacency='stored');
+create temp table changes(n);
+insert into changes select total_changes();
+select id, distance from sbfs where root = 1 order by distance, id;
+select id, distance from sbfs where root = 1 order by distance, id;
+insert into changes select total_changes();
+select max(n) - min(n) from changes;
+insert into sbfs(command) values ('rebuild');
+select k, v from sbfs_config where k in ('nodes', 'edges') order by k;
+select id, distance from sbfs where root = 1 order by distance, id;
+.connection 2
+.open --readonly ./test/bfsvtab.db
+.load ./bfsvtab
+.trace ./test/bfsvtab.db-trace
+select id, distance from sbfs where root = 1 order by distance, id;
+.trace off
+select 'stored adjacency not loaded' from (select readfile('./test/bfsvtab.db-trace') as t) where instr(t, '"sbfs_offsets"') = 0 or instr(t, 'SELECT "edges"."fromNode"') > 0;
+.connection 3
+.open ./test/bfsvtab.db
+insert into edges(fromNode, toNode) values (10, 11);
+select 'stamp not cleared' where (select count(*) from sbfs_stamp) > 0;
+.connection 2
+select id, distance from sbfs where root = 1 order by distance, id;
+.connection 1
+insert into sbfs(command) values ('rebuild');
+.connection 3
+drop table edges;
+.read ./test/fixture.sql
+.connection 2
+select id, distance from sbfs where root = 1 order by distance, id;
+.connection 3
+insert into edges(fromNode, toNode) values (10, 11);
+.connection 4
+.open ./test/bfsvtab.db
+.load ./bfsvtab
+create virtual table mbfs using bfsvtab(tablename='edges', fromcolumn='fromNode', tocolumn='toNode', adjacency='mapped');
+select id, distance from mbfs where root = 1 order by distance, id;
+select 'mapped file not written' where (select count(*) from fsdir('test') where name glob 'test/bfsvtab.db-bfsvtab-*') != 1;
+create temp table mapfile as select data from fsdir('test') where name glob 'test/bfsvtab.db-bfsvtab-*';
+create temp table edges(fromNode integer, toNode integer);
+insert into temp.edges(fromNode, toNode) values (1, 2), (2, 99);
+select id, distance from mbfs where root = 1 order by distance, id;
+select 'mapped file used for a temp table' where (select data from fsdir('test') where name glob 'test/bfsvtab.db-bfsvtab-*') != (select data from mapfile);
+drop table temp.edges;
+drop table mapfile;
+.connection 3
+insert into edges(fromNode, toNode) values (11, 12);
+.connection close 2
+.connection 2
+.open ./test/bfsvtab.db
+.load ./bfsvtab
+create temp table mapfile as select data from fsdir('test') where name glob 'test/bfsvtab.db-bfsvtab-*';
+select id, distance from mbfs where root = 1 order by distance, id;
+select 'mapped file not rewritten' where (select count(*) from fsdir('test') where name glob 'test/bfsvtab.db-bfsvtab-*') != 1 or (select data from fsdir('test') where name glob 'test/bfsvtab.db-bfsvtab-*') = (select data from mapfile);
+.connection close 3
+.connection 3
+.open ./test/bfsvtab.db
+.load ./bfsvtab
+.trace ./test/bfsvtab.db-trace
+select id, distance from mbfs where root = 1 order by distance, id;
+.trace off
+select 'mapped file not loaded' from (select readfile('./test/bfsvtab.db-trace') as t) where instr(t, 'SELECT "edges"."fromNode"') > 0 or instr(t, 'FROM "edges" LIMIT 1') = 0;
+.output ./test/bfsvtab.db-out
+pragma locking_mode = exclusive;
+.output stdout
+insert into edges(fromNode, toNode) values (12, 13);
+select id, distance from mbfs where root = 1 order by distance, id;
+insert into edges(fromNode, toNode) values (13, 14);
+.connection 2
+.connection close 3
+.connection 3
+.open ./test/bfsvtab.db
+.load ./bfsvtab
+select id, distance from mbfs where root = 1 order by distance, id;
+.connection 2
+select id, distance from mbfs where root = 1 order by distance, id;
+.connection 1
+create virtual table shbfs using bfsvtab(tablename='edges', fromcolumn='fromNode', tocolumn='toNode', adjacency='shared');
+select id, distance from shbfs where root = 1 order by distance, id;
+.connection 4
+.trace ./test/bfsvtab.db-trace
+select id, distance from shbfs where root = 1 order by distance, id;
+.trace off
+select 'shared adjacency not taken' from (select readfile('./test/bfsvtab.db-trace') as t) where instr(t, 'SELECT "edges"."fromNode"') > 0 or instr(t, 'FROM "edges" LIMIT 1') = 0;
+.connection 3
+insert into edges(fromNode, toNode) values (14, 15);
+.connection 4
+select id, distance from shbfs where root = 1 order by distance, id;
+.connection close 3
+.connection 3
+.open ./test/bfsvtab.db
+.load ./bfsvtab
+.output ./test/bfsvtab.db-out
+pragma locking_mode = exclusive;
+.output stdout
+insert into edges(fromNode, toNode) values (15, 16);
+select id, distance from shbfs where root = 1 order by distance, id;
+insert into edges(fromNode, toNode) values (16, 17);
+.connection 1
+.connection close 3
+select id, distance from shbfs where root = 1 order by distance, id;
@@ -1,4 +1,5 @@
 .read ./test/fixture.sql
+create temp view expected as
 with recursive
     bfs(id, parent, shortest_path, distance) as (
         select 1, null, '/' || 1 || '/',  0
@@ -11,3 +12,306 @@ with recursive
 select id, parent, shortest_path, min(distance) as distance from bfs
 group by id
 order by distance;
+select * from expected;
+select * from expected;
+select * from expected;
+insert into edges(fromNode, toNode) values (10, 11);
+select * from expected;
+select * from expected where distance <= 3;
+select * from expected where distance = 4;
+select * from expected where id = 4;
+select * from expected where id in (8, 4, 99);
+select * from expected where id = 11;
+select * from expected where id = 11 and distance <= 3;
+select * from expected where id = 99;
+select * from expected where id = 8;
+select * from expected;
+select * from expected where distance <= 3;
+select * from expected where id in (8, 4, 99);
+select * from expected;
+select id, distance from expected;
+select id, distance from expected;
+select * from expected;
+select * from expected;
+select id, distance from expected;
+create temp view expected_roots as
+with recursive
+    bfs(root, id, distance) as (
+        select 1, 1, 0
+        union all
+        select 7, 7, 0
+        union all
+        select bfs.root, edges.toNode, bfs.distance + 1
+        from edges, bfs
+        where edges.fromNode = bfs.id
+    )
+select root, id, distance from bfs;
+select root, id, min(distance) as distance from expected_roots group by root, id order by root, distance;
+select root, id, min(distance) as distance from expected_roots group by id order by distance;
+select root, id, min(distance) as distance from expected_roots group by id order by distance;
+select root, id, min(distance) as distance from expected_roots group by root, id order by distance, id;
+select root, id, min(distance) as distance from expected_roots where id = 8 group by root, id order by root;
+create table wedges as select fromNode, toNode, (fromNode * 7 + toNode) % 4 + 1 as w from edges;
+create temp view expected_weighted as
+with recursive
+    paths(id, cost, hops) as (
+        select 1, 0, 0
+        union all
+        select wedges.toNode, paths.cost + wedges.w, paths.hops + 1
+        from wedges, paths
+        where wedges.fromNode = paths.id
+    )
+select id, min(cost) as distance, hops from paths group by id;
+select id, distance, hops from expected_weighted order by distance, id;
+select id, distance, hops from expected_weighted where distance <= 8 order by distance, id;
+select id, distance from expected where id = 10;
+select id, distance from expected_weighted where id = 10;
+select id, distance from expected_weighted where id = 10;
+select id, distance from expected where id = 10;
+create table agraph(fromNode integer, toNode integer, w);
+insert into agraph(fromNode, toNode, w) values (1, 7, 1), (1, 5, 2), (7, 10, 4), (5, 10, 2);
+create temp view expected_agraph as
+with recursive
+    paths(id, parent, shortest_path, cost) as (
+        select 1, null, '/' || 1 || '/', 0
+        union all
+        select agraph.toNode, paths.id, paths.shortest_path || agraph.toNode || '/', paths.cost + agraph.w
+        from agraph, paths
+        where agraph.fromNode = paths.id
+    )
+select id, parent, shortest_path, min(cost) as distance from paths group by id;
+select id, parent, shortest_path, distance from expected_agraph where id = 10;
+select id, parent, shortest_path, distance from expected_agraph where id = 10;
+create table astar(fromNode integer, toNode integer, w);
+insert into astar(fromNode, toNode, w) values (1, 2, 1.6), (2, 10, 1.6), (1, 10, 5);
+with recursive n(i) as (select 101 union all select i + 1 from n where i < 150) insert into astar(fromNode, toNode, w) select 1, i, 2 from n union all select i, i + 100, 2 from n union all select i, i + 101, 2 from n where i < 150;
+create temp view expected_astar as
+with recursive
+    paths(id, parent, shortest_path, cost) as (
+        select 1, null, '/' || 1 || '/', 0
+        union all
+        select astar.toNode, paths.id, paths.shortest_path || astar.toNode || '/', paths.cost + astar.w
+        from astar, paths
+        where astar.fromNode = paths.id
+    )
+select id, parent, shortest_path, min(cost) as distance from paths group by id;
+select id, parent, shortest_path, distance from expected_astar where id = 10;
+select id, parent, shortest_path, distance from expected_astar where id = 10;
+create temp view expected_astar_expanded as
+select e.id, e.distance + atan2(e.id, 10) as fatan2, e.distance + glob(e.id, 10) as fglob
+from expected_astar as e
+where e.id != 10;
+select
+    (select count(*) from (select 1 union select astar.toNode from astar join expected_astar_expanded as x on x.id = astar.fromNode where astar.toNode != 10 and x.fatan2 < (select distance from expected_astar where id = 10))),
+    (select count(*) from (select 1 union select astar.toNode from astar join expected_astar_expanded as x on x.id = astar.fromNode where astar.toNode != 10 and x.fglob < (select distance from expected_astar where id = 10)));
+create temp view expected_reverse as
+with recursive
+    bfs(id, distance) as (
+        select 10, 0
+        union all
+        select edges.fromNode, bfs.distance + 1
+        from edges, bfs
+        where edges.toNode = bfs.id
+    )
+select id, min(distance) as distance from bfs group by id;
+select id, distance from expected_reverse order by distance, id;
+create temp view expected_both as
+with recursive
+    undirected(fromNode, toNode) as (
+        select fromNode, toNode from edges
+        union all
+        select toNode, fromNode from edges
+    ),
+    bfs(id, distance) as (
+        select 4, 0
+        union
+        select undirected.toNode, bfs.distance + 1
+        from undirected, bfs
+        where undirected.fromNode = bfs.id and bfs.distance < 10
+    )
+select id, min(distance) as distance from bfs group by id;
+select id, distance from expected_both order by distance, id;
+select id, distance from expected_both order by distance, id;
+select * from expected;
+select id, distance from expected order by distance, id;
+insert into edges(fromNode, toNode) values (11, 12), (2, 11);
+delete from edges where fromNode = 10 and toNode = 11;
+update edges set toNode = 5 where fromNode = 6 and toNode = 7;
+select * from expected;
+select id, distance from expected_both order by distance, id;
+create table redges(id integer primary key, fromNode integer, toNode integer);
+insert into redges(id, fromNode, toNode) values (1, 1, 2), (2, 2, 3);
+create temp view expected_redges as
+with recursive
+    bfs(id, distance) as (
+        select 1, 0
+        union all
+        select redges.toNode, bfs.distance + 1
+        from redges, bfs
+        where redges.fromNode = bfs.id
+    )
+select id, min(distance) as distance from bfs group by id;
+select id, distance from expected_redges order by distance, id;
+insert or replace into redges(id, fromNode, toNode) values (2, 2, 4);
+select id, distance from expected_redges order by distance, id;
+insert or ignore into redges(id, fromNode, toNode) values (1, 1, 5);
+select id, distance from expected_redges order by distance, id;
+insert or replace into redges(id, fromNode, toNode) values (2, 2, 5);
+select id, distance from expected_redges order by distance, id;
+drop table redges;
+create table redges(id integer primary key, fromNode integer, toNode integer);
+insert into redges(id, fromNode, toNode) values (1, 1, 3), (2, 3, 6);
+select id, distance from expected_redges order by distance, id;
+insert into redges(id, fromNode, toNode) values (3, 6, 7);
+select id, distance from expected_redges order by distance, id;
+select * from expected;
+select id, distance from expected_both order by distance, id;
+select id, distance from expected order by distance, id;
+select id, distance from expected order by distance, id;
+select id, distance from expected order by distance, id;
+create table wide(fromNode integer, toNode integer);
+with recursive n(i) as (select 10 union all select i + 1 from n where i < 20000) insert into wide(fromNode, toNode) select i, i + 1 from n;
+insert into wide(fromNode, toNode) values (1, 2), (2, 3);
+create temp view expected_wide as
+with recursive
+    bfs(id, parent, distance) as (
+        select 1, null, 0
+        union all
+        select wide.toNode, bfs.id, bfs.distance + 1
+        from wide, bfs
+        where wide.fromNode = bfs.id
+    )
+select id, parent, min(distance) as distance from bfs
+group by id;
+select id, parent, distance from expected_wide order by distance, id;
+begin;
+insert into wide(fromNode, toNode) values (3, 4);
+select id, parent, distance from expected_wide order by distance, id;
+commit;
+select count(*) from wide;
+create table tree(id integer primary key, parent integer);
+insert into tree(id, parent) values (1, null), (2, 1), (3, 1), (4, 2), (5, 4), (6, 3);
+create temp view expected_tree as
+with recursive
+    bfs(id, parent, shortest_path, distance) as (
+        select 1, null, '/' || 1 || '/', 0
+        union all
+        select tree.id, bfs.id, bfs.shortest_path || tree.id || '/', bfs.distance + 1
+        from tree, bfs
+        where tree.parent = bfs.id
+    )
+select id, parent, shortest_path, distance from bfs;
+select * from expected_tree where id = 5;
+select * from expected_tree where id = 6;
+create table star(fromNode integer, toNode integer);
+create index star_from on star(fromNode);
+with recursive n(i) as (select 2 union all select i + 1 from n where i < 10001) insert into star(fromNode, toNode) select 1, i from n union all select i, i + 10000 from n;
+create temp view expected_star as
+with recursive
+    bfs(id, parent, distance) as (
+        select 1, null, 0
+        union all
+        select star.toNode, bfs.id, bfs.distance + 1
+        from star, bfs
+        where star.fromNode = bfs.id
+    )
+select id, parent, min(distance) as distance from bfs
+group by id;
+select count(*), sum(parent), sum(distance), sum(id * distance) from expected_star;
+with recursive n(i) as (select 100000 union all select i + 1 from n where i < 250000) insert into star(fromNode, toNode) select i, i + 1 from n;
+select count(*), sum(parent), sum(distance), sum(id * distance) from expected_star;
+create table far(fromNode integer, toNode integer);
+insert into far(fromNode, toNode) values (1, 2), (2, 4000000000);
+with recursive
+    bfs(id, parent, distance) as (
+        select 1, null, 0
+        union all
+        select far.toNode, bfs.id, bfs.distance + 1
+        from far, bfs
+        where far.fromNode = bfs.id
+    )
+select id, parent, distance from bfs order by distance, id;
+with recursive
+    bfs(id, parent, distance) as (
+        select 1, null, 0
+        union all
+        select far.toNode, bfs.id, bfs.distance + 1
+        from far, bfs
+        where far.fromNode = bfs.id
+    )
+select id, parent, distance from bfs order by distance, id;
+insert into far(fromNode, toNode) values (4000000000, 3);
+with recursive
+    bfs(id, parent, distance) as (
+        select 1, null, 0
+        union all
+        select far.toNode, bfs.id, bfs.distance + 1
+        from far, bfs
+        where far.fromNode = bfs.id
+    )
+select id, parent, distance from bfs order by distance, id;
+create table aedges(fromNode integer, toNode integer);
+insert into aedges(fromNode, toNode) values (1, 2), (2, 3);
+create temp view expected_aux as
+with recursive
+    bfs(id, distance) as (
+        select 1, 0
+        union all
+        select aedges.toNode, bfs.distance + 1
+        from aedges, bfs
+        where aedges.fromNode = bfs.id
+    )
+select id, min(distance) as distance from bfs group by id;
+select id, distance from expected_aux order by distance, id;
+insert into aedges(fromNode, toNode) values (3, 4);
+select id, distance from expected_aux order by distance, id;
+.connection 1
+.read ./test/fixture.sql
+create temp view expected_file as
+with recursive
+    bfs(id, distance) as (
+        select 1, 0
+        union all
+        select edges.toNode, bfs.distance + 1
+        from edges, bfs
+        where edges.fromNode = bfs.id
+    )
+select id, min(distance) as distance from bfs group by id;
+create temp table changes(n);
+insert into changes select total_changes();
+select id, distance from expected_file order by distance, id;
+select id, distance from expected_file order by distance, id;
+insert into changes select total_changes();
+select max(n) - min(n) from changes;
+select 'edges', count(*) from edges
+union all
+select 'nodes', count(*) from (select fromNode from edges union select toNode from edges);
+select id, distance from expected_file order by distance, id;
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (10, 11);
+select id, distance from expected_file order by distance, id;
+drop table edges;
+.read ./test/fixture.sql
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (10, 11);
+select id, distance from expected_file order by distance, id;
+create temp table edges(fromNode integer, toNode integer);
+insert into temp.edges(fromNode, toNode) values (1, 2), (2, 99);
+select id, distance from expected_file order by distance, id;
+drop table temp.edges;
+insert into edges(fromNode, toNode) values (11, 12);
+select id, distance from expected_file order by distance, id;
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (12, 13);
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (13, 14);
+select id, distance from expected_file order by distance, id;
+select id, distance from expected_file order by distance, id;
+select id, distance from expected_file order by distance, id;
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (14, 15);
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (15, 16);
+select id, distance from expected_file order by distance, id;
+insert into edges(fromNode, toNode) values (16, 17);
+select id, distance from expected_file order by distance, id;